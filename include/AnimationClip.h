@@ -0,0 +1,86 @@
+#ifndef ANIMATIONCLIP_H
+#define ANIMATIONCLIP_H
+
+#include "SkeletalModel.h"
+#include "PoseBuffer.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <vector>
+#include <cstddef>
+
+// Keyframed joint animation. Each joint has an optional rotation track
+// (slerped) and an optional translation track (lerped); joints without a
+// track are left as they are when the clip is applied.
+//
+// Sampling walks every track in one pass. A Cursor remembers the key each
+// track was last sampled at, so playing forward only ever steps to the next
+// key instead of searching.
+
+class AnimationClip {
+public:
+    struct Cursor {
+        std::vector<size_t> rotationKeys;
+        std::vector<size_t> translationKeys;
+
+        size_t getMemoryUsage() const; // Approximate heap usage in bytes
+    };
+
+    AnimationClip();
+
+    void clear();
+    bool isEmpty() const;
+
+    size_t getJointCount() const;
+    float getDuration() const; // Time of the last key
+
+    // Distinct key times over all tracks, ascending
+    const std::vector<float>& getKeyframeTimes() const;
+
+    size_t getMemoryUsage() const; // Approximate heap usage in bytes
+
+    bool hasRotationTrack(int jointIndex) const;
+    bool hasTranslationTrack(int jointIndex) const;
+
+    // Raw keys of a joint's tracks, ascending in time; empty without a track
+    const std::vector<float>& getRotationKeyTimes(int jointIndex) const;
+    const std::vector<glm::quat>& getRotationKeyValues(int jointIndex) const;
+    const std::vector<float>& getTranslationKeyTimes(int jointIndex) const;
+    const std::vector<glm::vec3>& getTranslationKeyValues(int jointIndex) const;
+
+    // Insert a key, replacing any key of that track at the same time
+    void setRotationKey(int jointIndex, float time, const glm::quat& rotation);
+    void setTranslationKey(int jointIndex, float time, const glm::vec3& translation);
+
+    // Key the current rotation of every joint of a skeleton
+    void addKeyframe(float time, const SkeletalModel& model);
+
+    // Sample every track at time into pose, which grows to getJointCount()
+    // joints if smaller. Joints without a track keep their pose.
+    void sample(float time, Cursor& cursor, PoseBuffer& pose) const;
+
+private:
+    struct RotationTrack {
+        std::vector<float> times;
+        std::vector<glm::quat> values;
+    };
+
+    struct TranslationTrack {
+        std::vector<float> times;
+        std::vector<glm::vec3> values;
+    };
+
+    std::vector<RotationTrack> rotationTracks;       // Per joint, empty if unkeyed
+    std::vector<TranslationTrack> translationTracks;
+    std::vector<float> keyframeTimes;
+    float duration;
+
+    void reserveJoints(size_t jointCount);
+    void addKeyframeTime(float time);
+
+    // Index of the last key at or before time, starting from a cached key
+    static size_t findKey(const std::vector<float>& times, float time, size_t key);
+};
+
+#endif // ANIMATIONCLIP_H
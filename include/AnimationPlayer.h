@@ -0,0 +1,83 @@
+#ifndef ANIMATIONPLAYER_H
+#define ANIMATIONPLAYER_H
+
+#include "AnimationClip.h"
+#include "CompressedClip.h"
+#include "AnimationStream.h"
+#include "SkeletalModel.h"
+#include "PoseBuffer.h"
+
+// Plays an AnimationClip on a skeleton. The clip clock advances in fixed
+// steps of FIXED_TIMESTEP however often update() is called, so playback
+// speed and the sampled poses do not depend on the render frame rate.
+
+class AnimationPlayer {
+public:
+    static const double FIXED_TIMESTEP;        // Seconds
+    static const int MAX_STEPS_PER_UPDATE = 8; // Longer stalls drop time instead of catching up
+
+    AnimationPlayer();
+
+    const AnimationClip* getClip() const;
+    void setClip(const AnimationClip* clip);
+
+    // When set, sampled in place of the clip
+    const CompressedClip* getCompressedClip() const;
+    void setCompressedClip(const CompressedClip* compressedClip);
+
+    // When set, played in place of either clip. Frames that are not paged
+    // in yet keep the previous pose until a later update().
+    AnimationStream* getStream() const;
+    void setStream(AnimationStream* stream);
+
+    bool isPlaying() const;
+    void setPlaying(bool playing);
+    bool isLooping() const;
+    void setLooping(bool looping);
+    float getSpeed() const;
+    void setSpeed(float speed);
+
+    float getTime() const;
+    void setTime(float time); // Seek; the pose is applied on the next update()
+
+    // Advance by the elapsed frame time and pose the skeleton if the clip
+    // time moved. Returns true if the skeleton was posed.
+    bool update(double deltaTime, SkeletalModel& model);
+
+    // Pose the skeleton at the current clip time; false if a streamed
+    // frame was not resident
+    bool apply(SkeletalModel& model);
+
+    // update() without posing a skeleton, for callers that layer the pose
+    // first: advance the clock and return true if the pose needs sampling.
+    // sample() fills the tracked joints of out at the current clip time.
+    bool advance(double deltaTime);
+    bool sample(PoseBuffer& out);
+
+    // Joints the playing source keys (every joint of a stream)
+    bool hasRotationTrack(int jointIndex) const;
+    bool hasTranslationTrack(int jointIndex) const;
+
+    // Approximate heap usage in bytes: the cursor and pose, not the clips
+    size_t getMemoryUsage() const;
+
+private:
+    const AnimationClip* clip;
+    const CompressedClip* compressedClip;
+    AnimationStream* stream;
+    AnimationClip::Cursor cursor;
+    double time;
+    double accumulator; // Elapsed time not yet consumed by a fixed step
+    bool playing;
+    bool looping;
+    float speed;
+    bool poseDirty;
+
+    PoseBuffer pose;
+
+    bool hasClip() const;
+    float getDuration() const;
+    void step();
+};
+
+#endif // ANIMATIONPLAYER_H
@@ -0,0 +1,98 @@
+#ifndef ANIMATIONSTREAM_H
+#define ANIMATIONSTREAM_H
+
+#include "MappedFile.h"
+#include "PoseBuffer.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Long animation takes played straight from a memory-mapped file.
+//
+// The file holds one pose per frame at a fixed sample rate: per joint a
+// smallest-three rotation (CompressedClip::encodeRotation, 6 bytes) and a
+// float translation. Frames are grouped into chunks of framesPerChunk
+// frames, about TARGET_CHUNK_SIZE bytes each.
+//
+// A background thread keeps the chunks around the playhead resident:
+// CHUNKS_BEHIND before it and CHUNKS_AHEAD after it are faulted in, and
+// chunks that leave that window are released, so memory use does not grow
+// with the length of the take. sample() never waits for the disk; if the
+// frames it needs are not resident yet it asks for them and returns false.
+//
+// Layout: Header, then the chunks back to back.
+
+class AnimationStream {
+public:
+    struct Header {
+        char magic[4];
+        uint32_t version;
+        uint32_t jointCount;
+        uint32_t frameCount;
+        uint32_t framesPerChunk;
+        float sampleRate;
+        uint64_t chunkSize; // Bytes
+    };
+
+    static const uint32_t VERSION = 1;
+    static const size_t ROTATION_BYTES = 3 * sizeof(uint16_t);
+    static const size_t TRANSLATION_BYTES = 3 * sizeof(float);
+    static const size_t TARGET_CHUNK_SIZE = 256 * 1024;
+    static const size_t CHUNKS_AHEAD = 4;
+    static const size_t CHUNKS_BEHIND = 1;
+
+    AnimationStream();
+    ~AnimationStream();
+
+    AnimationStream(const AnimationStream&) = delete;
+    AnimationStream& operator=(const AnimationStream&) = delete;
+
+    bool open(const std::string& path);
+    void close();
+    bool isOpen() const;
+
+    size_t getJointCount() const;
+    size_t getFrameCount() const;
+    float getSampleRate() const;
+    float getDuration() const;
+    size_t getFileSize() const;
+    size_t getResidentSize() const; // Bytes of the chunks held around the playhead
+
+    // Pose at time, interpolated between the two nearest frames. Returns
+    // false, leaving pose unchanged, if those frames are not resident yet.
+    bool sample(float time, PoseBuffer& pose);
+
+    // Shared with AnimationStreamWriter
+    static size_t getFrameSize(size_t jointCount);
+    static bool isValidHeader(const Header& header);
+    static void fillHeader(Header& header, uint32_t jointCount, uint32_t frameCount,
+                           uint32_t framesPerChunk, float sampleRate);
+
+private:
+    MappedFile file;
+    Header header;
+
+    // Prefetch thread and the chunk the playhead is in
+    std::thread prefetchThread;
+    std::mutex mutex;
+    std::condition_variable wakeCondition;
+    bool stopping;
+    std::atomic<size_t> requestedChunk;
+
+    // Chunks [residentBegin, residentEnd) are paged in and safe to read
+    std::atomic<size_t> residentBegin;
+    std::atomic<size_t> residentEnd;
+
+    size_t getChunkCount() const;
+    uint64_t getChunkOffset(size_t chunk) const;
+    const unsigned char* getFrameData(size_t frame) const;
+    bool isResident(size_t chunk) const;
+    void requestChunk(size_t chunk);
+    void prefetchLoop();
+};
+
+#endif // ANIMATIONSTREAM_H
@@ -0,0 +1,45 @@
+#ifndef ANIMATIONSTREAMWRITER_H
+#define ANIMATIONSTREAMWRITER_H
+
+#include "AnimationStream.h"
+#include "PoseBuffer.h"
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Writes poses into the AnimationStream format one frame at a time, so a
+// take of any length can be written without holding it in memory.
+
+class AnimationStreamWriter {
+public:
+    AnimationStreamWriter();
+    ~AnimationStreamWriter(); // Finishes the file if still open
+
+    AnimationStreamWriter(const AnimationStreamWriter&) = delete;
+    AnimationStreamWriter& operator=(const AnimationStreamWriter&) = delete;
+
+    bool open(const std::string& path, size_t jointCount, float sampleRate);
+
+    // Append the local rotation and translation of every joint
+    bool writeFrame(const PoseBuffer& pose);
+
+    // Write the final header
+    bool close();
+
+    bool isOpen() const;
+    size_t getFrameCount() const;
+    uint64_t getBytesWritten() const;
+
+private:
+    std::ofstream file;
+    uint32_t jointCount;
+    uint32_t frameCount;
+    uint32_t framesPerChunk;
+    float sampleRate;
+
+    std::vector<unsigned char> buffer; // One encoded frame
+};
+
+#endif // ANIMATIONSTREAMWRITER_H
@@ -0,0 +1,74 @@
+#ifndef BLENDTREE_H
+#define BLENDTREE_H
+
+#include "PoseBuffer.h"
+#include "SkeletalModel.h"
+
+#include <vector>
+#include <cstddef>
+
+// Layers several poses into one. The tree is a flat list of nodes, each
+// holding a whole PoseBuffer; a node may only take earlier nodes as
+// inputs, so evaluate() is a single forward pass with one buffer operation
+// per node and the last node is the result.
+//
+// Input nodes are filled by the caller (a sampled clip, a captured pose);
+// the other nodes combine them:
+//   BLEND         lerp from a to b by weight
+//   MASKED_BLEND  as BLEND, with the weight scaled per joint by a mask
+//   ADDITIVE      b is a difference pose (PoseBuffer::makeAdditive) added
+//                 on top of a by weight, optionally masked
+
+class BlendTree {
+public:
+    enum NodeType { INPUT, BLEND, MASKED_BLEND, ADDITIVE };
+
+    explicit BlendTree(size_t jointCount = 0);
+
+    void clear();
+    size_t getJointCount() const;
+    void setJointCount(size_t jointCount);
+
+    // Each returns the new node's index, or -1 if an input is not an earlier node
+    int addInput();
+    int addBlend(int a, int b, float weight);
+    int addMaskedBlend(int a, int b, int mask, float weight);
+    int addAdditive(int base, int additive, float weight, int mask = -1);
+
+    // Per-joint weights in [0, 1]; returns the mask index
+    int addMask(const std::vector<float>& jointWeights);
+
+    // 1 for rootJoint and every joint below it, 0 elsewhere
+    static std::vector<float> makeSubtreeMask(const SkeletalModel& model, int rootJoint);
+
+    size_t getNodeCount() const;
+    NodeType getNodeType(int node) const;
+    float getWeight(int node) const;
+    void setWeight(int node, float weight);
+
+    // The pose buffer of a node; fill the INPUT nodes before evaluate()
+    PoseBuffer& getPose(int node);
+
+    // Run every node in order and return the last one's pose
+    const PoseBuffer& evaluate();
+
+    size_t getMemoryUsage() const; // Approximate heap usage in bytes
+
+private:
+    struct Node {
+        NodeType type;
+        int inputA;
+        int inputB;
+        int mask;
+        float weight;
+    };
+
+    size_t jointCount;
+    std::vector<Node> nodes;
+    std::vector<PoseBuffer> poses; // One per node
+    std::vector<std::vector<float>> masks;
+
+    int addNode(NodeType type, int inputA, int inputB, int mask, float weight);
+};
+
+#endif // BLENDTREE_H
@@ -0,0 +1,86 @@
+#ifndef BVHIMPORTER_H
+#define BVHIMPORTER_H
+
+#include "AnimationClip.h"
+#include "MappedFile.h"
+#include "SkeletalModel.h"
+
+#include <glm/glm.hpp>
+
+#include <string>
+#include <vector>
+#include <cstddef>
+
+// Reads Biovision .bvh motion capture. The HIERARCHY block becomes the
+// joints of a SkeletalModel (End Sites become channel-less leaf joints so
+// the last bone of each chain is drawn), and the MOTION block is keyed into
+// an AnimationClip: a rotation track for every joint with rotation channels
+// and a translation track for every joint with position channels. Position
+// channels replace the joint's OFFSET.
+//
+// The file is memory-mapped and parsed in one pass over the bytes. Motion
+// values are read with parseFloat(), which works on the mapped characters
+// directly, so the only allocations while reading frames are the clip's
+// own key arrays.
+
+class BvhImporter {
+public:
+    BvhImporter();
+
+    // Scale offsets and positions so the rest pose reaches fitSize from the
+    // root; 0 keeps the file's units
+    void setFitSize(float fitSize);
+
+    // Replaces the contents of clip; model must not have joints yet
+    bool load(const std::string& path, SkeletalModel& model, AnimationClip& clip);
+
+    size_t getFrameCount() const;
+    float getFrameTime() const;
+    size_t getChannelCount() const;
+    float getScale() const;
+
+    // Parse a decimal number at in; returns the first character after it,
+    // or nullptr if in does not start a number
+    static const char* parseFloat(const char* in, const char* end, float& value);
+
+private:
+    enum ChannelType { X_POSITION, Y_POSITION, Z_POSITION, X_ROTATION, Y_ROTATION, Z_ROTATION };
+
+    struct JointChannels {
+        int joint;
+        int count;
+        ChannelType types[6]; // In file order
+        bool hasPosition;
+        bool hasRotation;
+    };
+
+    static const int MAX_CHANNELS_PER_JOINT = 6;
+
+    MappedFile file;
+    const char* cursor;
+    const char* end;
+    int line;
+
+    float fitSize;
+    float scale;
+    size_t frameCount;
+    float frameTime;
+    size_t channelCount;
+
+    std::vector<glm::vec3> offsets; // Per joint, in file units
+    std::vector<int> parents;
+    std::vector<JointChannels> channels;
+
+    // Tokens are whitespace separated; a token is [token, token + length)
+    bool nextToken(const char*& token, size_t& length);
+    bool expect(const char* keyword);
+    bool readNumber(float& value);
+    void skipLine();
+    bool fail(const char* message) const;
+
+    bool parseJoint(int parent);
+    bool parseChannels(int joint);
+    bool parseMotion(AnimationClip& clip);
+};
+
+#endif // BVHIMPORTER_H
@@ -0,0 +1,100 @@
+#ifndef CHARACTERASSET_H
+#define CHARACTERASSET_H
+
+#include "SkeletalModel.h"
+#include "SkinWeights.h"
+#include "PackedSkinWeights.h"
+#include "SkinningKernel.h"
+
+#include "glad/glad.h"
+#include <GLFW/glfw3.h>
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <memory>
+#include <cstddef>
+
+// The part of an imported character that never changes after import: the
+// bind mesh, the skeleton's bind hierarchy, the attachment weights and what
+// is derived from them (bind normals, the SIMD kernel layout, LOD data) and
+// the static vertex buffer of the GPU skinning path.
+//
+// Characters imported from the same files share one asset through a
+// shared_ptr<const CharacterAsset>. Each ImportCharacter keeps only its
+// pose: its joints, palette, animation state and, when skinned on the CPU,
+// its own skinned vertex buffer.
+
+class CharacterAsset {
+public:
+    // Shared with shaders/skinning_vertex_shader.glsl
+    static const int GPU_MAX_INFLUENCES = 4;
+
+    CharacterAsset(); // No mesh and no skeleton
+
+    // One empty asset shared by every character that has none of its own
+    static const std::shared_ptr<const CharacterAsset>& getEmpty();
+
+    // jointTransforms are the local bind transforms, parentIndices[0] == -1.
+    // packedAttachments may be empty; attachments is what the skinning
+    // paths read (the CSR expansion of packedAttachments when it is set).
+    CharacterAsset(const std::vector<glm::vec3>& bindVertices, const std::vector<std::vector<int>>& faces,
+                   const std::vector<glm::mat4>& jointTransforms, const std::vector<int>& parentIndices,
+                   const SkinWeights& attachments, const PackedSkinWeights& packedAttachments);
+    ~CharacterAsset();
+
+    CharacterAsset(const CharacterAsset&) = delete;
+    CharacterAsset& operator=(const CharacterAsset&) = delete;
+
+    // Give model its own joints in the bind pose; model must not have joints yet
+    void createSkeleton(SkeletalModel& model) const;
+    size_t getJointCount() const;
+
+    // Getters for the bind mesh
+    const std::vector<glm::vec3>& getBindVertices() const;
+    const std::vector<glm::vec3>& getBindNormals() const; // Area-weighted, unit length
+    const std::vector<std::vector<int>>& getFaces() const;
+
+    // Getters for the weights and the SIMD layout built from them
+    const SkinWeights& getAttachments() const;
+    const PackedSkinWeights& getPackedAttachments() const;
+    const SkinningKernel& getSkinningKernel() const;
+
+    // Heaviest joint of each vertex (-1 if none) and the bind pose bounding sphere
+    const std::vector<int>& getDominantJoints() const;
+    glm::vec3 getBoundsCenter() const;
+    float getBoundsRadius() const;
+
+    // Bind positions and normals with the GPU_MAX_INFLUENCES heaviest
+    // influences per corner, weights as 16-bit unorm. Built on first use,
+    // from the render thread; the color attribute (location 2) is left to
+    // each character as a constant.
+    GLuint getSkinnedVAO() const;
+
+    // Approximate heap usage in bytes
+    size_t getMemoryUsage() const;
+
+private:
+    std::vector<glm::vec3> bindVertices;
+    std::vector<glm::vec3> bindNormals;
+    std::vector<std::vector<int>> faces;
+
+    std::vector<glm::mat4> jointTransforms;
+    std::vector<int> parentIndices;
+
+    SkinWeights attachments;
+    PackedSkinWeights packedAttachments;
+    SkinningKernel skinningKernel;
+
+    std::vector<int> dominantJoints;
+    glm::vec3 boundsCenter;
+    float boundsRadius;
+
+    mutable GLuint skinnedVAO, skinnedVBO, skinnedEBO;
+
+    void computeBindNormals();
+    void computeLODData();
+    void setupSkinnedMeshBuffer() const;
+};
+
+#endif // CHARACTERASSET_H
@@ -0,0 +1,108 @@
+#ifndef COMPRESSEDCLIP_H
+#define COMPRESSEDCLIP_H
+
+#include "AnimationClip.h"
+#include "PoseBuffer.h"
+#include "SkeletalModel.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <cstdint>
+#include <vector>
+#include <cstddef>
+
+// Compact, read-only form of an AnimationClip.
+//
+// Rotations are stored smallest-three: the largest quaternion component is
+// dropped (and rebuilt from unit length) and the other three are quantized
+// to 15 bits, 6 bytes per key. Translations are quantized to 16 bits per
+// component within each track's range.
+//
+// Key times are integer time units, at most 1/TIME_UNITS_PER_INTERVAL of
+// the closest two source keys. Each key stores the low 16 bits; a per-track
+// page table holds the first key of every 65536 units, so a long take keeps
+// its sub-frame resolution (a short clip is a single page).
+//
+// Keys that interpolation between their neighbours reproduces are dropped.
+// Errors are budgeted in world space: a joint's error moves everything
+// below it, so the tolerance is split over the longest joint chain, and a
+// rotation error is measured at the joint's farthest descendant (or, for a
+// leaf, its own bone length). The bound is conservative; measureError()
+// reports the actual error.
+//
+// Sampling uses the same cursor scheme as AnimationClip, with nlerp
+// between rotation keys.
+
+class CompressedClip {
+public:
+    static constexpr float DEFAULT_TOLERANCE = 0.001f; // Model units
+    static const int TIME_UNITS_PER_INTERVAL = 64;     // Time units between the closest two source keys
+
+    CompressedClip();
+
+    // Returns false if the clip is empty or too long for 32-bit time units
+    bool compress(const AnimationClip& clip, const SkeletalModel& model, float tolerance = DEFAULT_TOLERANCE);
+    void clear();
+
+    bool isEmpty() const;
+    size_t getJointCount() const;
+    float getDuration() const;
+    float getTolerance() const;
+
+    bool hasRotationTrack(int jointIndex) const;
+    bool hasTranslationTrack(int jointIndex) const;
+
+    // Key counts before and after reduction, and bytes of both forms
+    size_t getSourceKeyCount() const;
+    size_t getKeyCount() const;
+    size_t getSourceSize() const;
+    size_t getCompressedSize() const;
+
+    size_t getMemoryUsage() const; // Approximate heap usage in bytes, with vector slack
+
+    // Same contract as AnimationClip::sample()
+    void sample(float time, AnimationClip::Cursor& cursor, PoseBuffer& pose) const;
+
+    // Largest world-space distance between joint positions and leaf tips
+    // of the two clips, sampled at sampleRate over the clip
+    static float measureError(const AnimationClip& original, const CompressedClip& compressed,
+                              const SkeletalModel& model, float sampleRate = 60.0f);
+
+    // Smallest-three encoding, shared with the error checks
+    static void encodeRotation(const glm::quat& rotation, uint16_t* out);
+    static glm::quat decodeRotation(const uint16_t* in);
+
+private:
+    struct Track {
+        uint32_t firstKey;
+        uint32_t keyCount; // 0 without a track
+    };
+
+    std::vector<Track> rotationTracks; // Per joint
+    std::vector<Track> translationTracks;
+    std::vector<uint16_t> rotationTimes;     // Low 16 bits of the time units
+    std::vector<uint16_t> rotationValues;    // 3 per key
+    std::vector<uint16_t> translationTimes;
+    std::vector<uint16_t> translationValues; // 3 per key
+    std::vector<uint32_t> rotationPages;     // pageCount per joint: first key of the track in each page
+    std::vector<uint32_t> translationPages;
+    std::vector<glm::vec3> translationMins;  // Per joint
+    std::vector<glm::vec3> translationSteps;
+
+    float duration;
+    double timeStep;  // Seconds per time unit
+    size_t pageCount; // 65536 time units each
+    float tolerance;
+    size_t sourceKeyCount;
+    size_t sourceSize;
+
+    void compressRotationTrack(int joint, const AnimationClip& clip, float maxAngle);
+    void compressTranslationTrack(int joint, const AnimationClip& clip, float maxDistance);
+    uint32_t quantizeTime(float time) const;
+
+    // Page table of a compressed track: the first kept key in each page
+    void addPages(const std::vector<uint32_t>& keptTimes, std::vector<uint32_t>& pages) const;
+};
+
+#endif // COMPRESSEDCLIP_H
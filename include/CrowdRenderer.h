@@ -0,0 +1,75 @@
+#ifndef CROWDRENDERER_H
+#define CROWDRENDERER_H
+
+#include "ImportCharacter.h"
+#include "CharacterAsset.h"
+#include "Shape.h"
+
+#include "glad/glad.h"
+#include <GLFW/glfw3.h>
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <cstddef>
+
+// Instanced drawing of GPU-skinned characters. Characters that share an
+// asset and a blending method are drawn by one glDrawElementsInstanced
+// call over the asset's static buffer. Every instance's model matrix,
+// color and palette are packed into one texture buffer, uploaded once per
+// frame, that the skinning shader indexes with gl_InstanceID.
+//
+// Draw calls and state changes depend on the number of distinct assets,
+// not on the number of characters. Only a crowd larger than
+// GL_MAX_TEXTURE_BUFFER_SIZE texels is split into more uploads and draws.
+
+class CrowdRenderer {
+public:
+    // Characters packed per WorkerPool job
+    static const size_t CHARACTERS_PER_CHUNK = 64;
+    static const GLint CROWD_TEXTURE_UNIT = 1;
+
+    CrowdRenderer();
+    ~CrowdRenderer();
+
+    bool isEnabled() const;
+    void setEnabled(bool enabled);
+
+    // Draw every character among shapes that the GPU path would draw, with
+    // skinningProgram (already holding the camera and lights). Returns the
+    // shapes that were not drawn; with crowd mode off, that is all of them.
+    // Poses must be up to date (PoseStage).
+    std::vector<Shape*> draw(const std::vector<Shape*>& shapes, GLuint skinningProgram);
+
+    // Statistics of the last draw()
+    size_t getInstanceCount() const;
+    size_t getDrawCallCount() const;
+    size_t getUploadSize() const; // Bytes
+    double getTime() const;       // Milliseconds of CPU time in draw()
+
+private:
+    // Consecutive instances in the texel buffer drawn by one call
+    struct CrowdDraw {
+        const CharacterAsset* asset;
+        bool dualQuaternion;
+        size_t firstCharacter, characterCount;
+        size_t firstTexel, stride;
+    };
+
+    bool enabled;
+    std::vector<ImportCharacter*> characters;
+    std::vector<size_t> texelOffsets; // Per character, into texels
+    std::vector<CrowdDraw> draws;
+    std::vector<glm::vec4> texels;
+
+    GLuint crowdBuffer, crowdTexture;
+    GLint maxTexels;
+
+    size_t instanceCount, drawCallCount, uploadSize;
+    double time;
+
+    // Pack, upload and draw draws[firstDraw..], which fill texelCount texels
+    void flush(GLuint skinningProgram, size_t firstDraw, size_t texelCount);
+};
+
+#endif // CROWDRENDERER_H
@@ -0,0 +1,33 @@
+#ifndef DUALQUATERNION_H
+#define DUALQUATERNION_H
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+// Unit dual quaternion for a rigid transform: real holds the rotation and
+// dual = 0.5 * (0, translation) * real. Stored as 8 floats, real then dual,
+// each in glm's x, y, z, w order; the skinning kernel and the skinning
+// shader read the palette in that layout.
+
+class DualQuaternion {
+public:
+    glm::quat real;
+    glm::quat dual;
+
+    DualQuaternion(); // Identity
+    DualQuaternion(const glm::quat& rotation, const glm::vec3& translation);
+
+    // Rotation and translation of a rigid (unscaled) transform
+    static DualQuaternion fromMatrix(const glm::mat4& transform);
+
+    glm::vec3 getTranslation() const;
+
+    // Divide both parts by the length of the real part, as needed after blending
+    void normalize();
+
+    // Apply to a point (rotation and translation) or a direction (rotation only)
+    glm::vec3 transformPoint(const glm::vec3& point) const;
+    glm::vec3 transformVector(const glm::vec3& vector) const;
+};
+
+#endif // DUALQUATERNION_H
@@ -12,6 +12,8 @@
 #include "ImportShape.h"
 #include "ImportCurve.h"
 #include "ImportCharacter.h"
+#include "CharacterAsset.h"
+#include "BvhImporter.h"
 
 #include "glad/glad.h"
 #include <GLFW/glfw3.h>
@@ -23,6 +25,7 @@
 #include <tinyfiledialogs.h>
 
 #include <unistd.h>
+#include <sys/stat.h>
 #include <limits.h>
 #include <iostream>
 #include <fstream>
@@ -30,6 +33,7 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <memory>
 #include <cctype>  // For std::toupper and std::tolower
 
 // The FileImporter class encapsulates the logic for importing .obj, .swp, and character files.
@@ -48,8 +52,36 @@ public:
     int importSwpFile(ShapeManager& shapeManager);
     int importCharacterFile(ShapeManager& shapeManager);
 
+    // Imports a .bvh motion capture file as a skeleton-only character whose
+    // clip holds the capture
+    int importBvhFile(ShapeManager& shapeManager);
+
+    // Skin weight compression applied by importCharacterFile
+    void setSkinInfluenceLimit(int maxInfluences);
+    void setSkinWeightPrecision(PackedSkinWeights::Precision precision);
+
 private:
 
+    int skinInfluenceLimit = PackedSkinWeights::DEFAULT_MAX_INFLUENCES;
+    PackedSkinWeights::Precision skinWeightPrecision = PackedSkinWeights::UNORM8;
+
+    // Imported .bvh skeletons are scaled to reach this far from the root
+    static constexpr float BVH_FIT_SIZE = 1.0f;
+
+    // Largest vertex displacement the packed weights cause, measured with
+    // every joint rotated by PRUNING_PROBE_ANGLE degrees about each axis
+    static constexpr float PRUNING_PROBE_ANGLE = 30.0f;
+    float measurePruningError(const CharacterAsset& asset, const SkinWeights& reference);
+
+    // Read the .obj, .skel and .attach files into a new asset
+    std::shared_ptr<const CharacterAsset> loadCharacterAsset(const std::string& objPath);
+
+    // Assets of the characters alive in the scene, by file paths, file
+    // times and weight settings. Weak, so an asset goes away with the last
+    // character using it; its entry is erased on the next import.
+    static std::map<std::string, std::weak_ptr<const CharacterAsset>> characterAssets;
+    std::string getCharacterAssetKey(const std::string& objPath);
+
     // Extracts the shape type from the file name
     std::string extractShapeType(const std::string& filename);
 	
@@ -0,0 +1,90 @@
+#ifndef IKCHAIN_H
+#define IKCHAIN_H
+
+#include "SkeletalModel.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <vector>
+
+// Inverse kinematics for one chain of joints: the end joint and the
+// boneCount joints above it are rotated so the end joint reaches a target
+// in model space.
+//
+// solve() reads the chain's world positions from the skeleton once, runs
+// CCD or FABRIK on that flat position array, and only then converts the
+// moved bones back into local rotations. Full FK runs once per solve, not
+// once per iteration. Bone lengths are kept; joints are unconstrained.
+
+class IKChain {
+public:
+    enum Method { CCD, FABRIK };
+
+    static const int DEFAULT_MAX_ITERATIONS = 16;
+    static constexpr float DEFAULT_TOLERANCE = 0.001f; // Model units
+    static constexpr float UNCHANGED_DISTANCE = 1e-6f; // Solved joints closer than this to the pose are not applied
+
+    IKChain();
+
+    // Returns false if endJoint does not have boneCount ancestors
+    bool setJoints(const SkeletalModel& model, int endJoint, int boneCount);
+    int getEndJoint() const;
+    int getBoneCount() const;
+
+    glm::vec3 getTarget() const;
+    void setTarget(const glm::vec3& target);
+    Method getMethod() const;
+    void setMethod(Method method);
+    int getMaxIterations() const;
+    void setMaxIterations(int maxIterations);
+    float getTolerance() const;
+    void setTolerance(float tolerance);
+
+    // Pose the chain toward the target. Returns true if the end joint ended
+    // within the tolerance; stops early once it is. Skipped while neither
+    // the target nor the skeleton has changed since the last solve, and the
+    // skeleton is left untouched when the solve would not move the chain
+    // (an unreachable target keeps failing without bumping the pose version).
+    bool solve(SkeletalModel& model);
+
+    // Results of the last solve()
+    int getIterations() const;
+    float getError() const;      // Distance from the end joint to the target
+    double getSolveTime() const; // Milliseconds
+
+    size_t getMemoryUsage() const; // Approximate heap usage in bytes
+
+    // Smallest rotation taking direction from onto to, and the rotation part
+    // of a joint's world transform (scale removed)
+    static glm::quat shortestArc(const glm::vec3& from, const glm::vec3& to);
+    static glm::quat worldRotation(const glm::mat4& transform);
+
+private:
+    std::vector<int> joints; // Chain root first, end joint last
+    glm::vec3 target;
+    Method method;
+    int maxIterations;
+    float tolerance;
+
+    int iterations;
+    float error;
+    double solveTime;
+
+    // Target and skeleton pose version the last solve finished with
+    glm::vec3 solvedTarget;
+    unsigned long solvedPoseVersion;
+    bool solved;
+
+    // Reused between solves
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec3> originalPositions;
+    std::vector<float> boneLengths;
+    std::vector<glm::quat> worldRotations;
+
+    void solveCCD();
+    void solveFABRIK();
+    void applyRotations(SkeletalModel& model);
+};
+
+#endif // IKCHAIN_H
@@ -2,7 +2,20 @@
 #define IMPORTCHARACTER_H
 
 #include "Shape.h"
+#include "CharacterAsset.h"
 #include "SkeletalModel.h"
+#include "SkinWeights.h"
+#include "PackedSkinWeights.h"
+#include "SkinningKernel.h"
+#include "VertexCache.h"
+#include "VertexCacheWriter.h"
+#include "AnimationClip.h"
+#include "AnimationPlayer.h"
+#include "AnimationStream.h"
+#include "AnimationStreamWriter.h"
+#include "BlendTree.h"
+#include "IKChain.h"
+#include "JiggleBones.h"
 
 #include "glad/glad.h"
 #include <GLFW/glfw3.h>
@@ -11,6 +24,7 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -20,24 +34,165 @@ public:
     ~ImportCharacter();
     
     enum DisplayMode { SKELETAL, MESH };
+    enum SkinningBackend { CPU_SCALAR, CPU_SIMD, GPU };
+    enum SkinningMethod { LINEAR_BLEND, DUAL_QUATERNION };
+    enum SkinningLOD { LOD_FULL, LOD_RIGID };
 
     // Getter and setter for skeletal model
     SkeletalModel& getSkeletalModel();
     void setJointTransform(int jointIndex, float rX, float rY, float rZ);
 
-    // Getters and setters for bindVertices
+    // Getter and setter for the shared bind mesh, hierarchy and weights.
+    // The asset does not give the character joints; see createSkeleton().
+    const std::shared_ptr<const CharacterAsset>& getAsset() const;
+    void setAsset(const std::shared_ptr<const CharacterAsset>& asset);
+
+    // Getters for the asset's bind vertices and attachments
     const std::vector<glm::vec3>& getBindVertices() const;
-    void setBindVertices(const std::vector<glm::vec3>& vertices);	
+    const SkinWeights& getAttachments() const;
+
+    // Pruned and quantized attachments from import; the skinning paths use
+    // their CSR expansion. Empty when imported with full weights.
+    const PackedSkinWeights& getPackedAttachments() const;
+
+    // Approximate heap usage of this character alone, without the asset
+    size_t getInstanceMemoryUsage() const;
 
-    // Getters and setters for attachments
-    const std::vector<std::vector<float>>& getAttachments() const;
-    void setAttachments(const std::vector<std::vector<float>>& attachments);
+    // A new character on the same asset with its own skeleton in the bind
+    // pose, this character's display and skinning settings and a copy of its
+    // clip. nullptr if the skeleton did not come from the asset (.bvh).
+    ImportCharacter* createInstance(int id) const;
 
     // Getter and setter for display mode
     DisplayMode getDisplayMode() const;
     void setDisplayMode(DisplayMode mode);
 
-    // Update vertices for SSD
+    // Getter and setter for skinning backend
+    SkinningBackend getSkinningBackend() const;
+    void setSkinningBackend(SkinningBackend backend);
+    const SkinningKernel& getSkinningKernel() const;
+
+    // Getter and setter for the blending method, used by every backend
+    SkinningMethod getSkinningMethod() const;
+    void setSkinningMethod(SkinningMethod method);
+
+    // Milliseconds spent skinning in the last CPU mesh update
+    double getSkinningTime() const;
+
+    // Skinning level of detail: LOD_RIGID moves each vertex with its heaviest
+    // joint only. Automatic LOD switches to rigid once the projected height
+    // drops below LOD_RIGID_PIXELS and back above LOD_FULL_PIXELS; the gap
+    // keeps a character near the threshold from flickering between the two.
+    SkinningLOD getSkinningLOD() const;
+    void setSkinningLOD(SkinningLOD lod); // Also turns automatic LOD off
+    bool isAutomaticLOD() const;
+    void setAutomaticLOD(bool enabled);
+    float getProjectedSize() const; // Pixels, from the last updateSkinningLOD
+
+    // Pick the LOD for this frame's camera; called before draw()
+    void updateSkinningLOD(const glm::mat4& view, const glm::mat4& projection, int viewportHeight);
+
+    static constexpr float LOD_RIGID_PIXELS = 80.0f;
+    static constexpr float LOD_FULL_PIXELS = 100.0f;
+
+    // GPU skinning limits, shared with shaders/skinning_vertex_shader.glsl
+    static const int GPU_MAX_INFLUENCES = CharacterAsset::GPU_MAX_INFLUENCES;
+    static const int GPU_MAX_JOINTS = 128;
+    static const GLuint JOINT_PALETTE_BINDING = 0; // Uniform buffer binding point of the palette
+    static const GLuint DUAL_QUATERNION_PALETTE_BINDING = 1; // And of the dual quaternion palette
+
+    // Setter for the program used by the GPU backend (0 = unavailable)
+    void setSkinningShaderProgram(GLuint shaderProgram);
+    bool isGPUSkinningAvailable() const;
+
+    // The mesh is drawn by the skinning shader (not while recording or playing a cache)
+    bool usesGPUSkinning() const;
+
+    // Crowd rendering: the model matrix (4 texels), color with the rigid LOD
+    // flag in w (1 texel) and the palette for the blending method (4 texels
+    // per matrix, 2 per dual quaternion), laid out as the skinning shader
+    // reads them in crowd mode. Call after the pose is updated.
+    static const int CROWD_HEADER_TEXELS = 5;
+    size_t getCrowdTexelCount() const;
+    void writeCrowdTexels(glm::vec4* out) const;
+
+    // Vertices re-skinned and VBO ranges uploaded by the last CPU mesh update
+    size_t getReskinnedVertexCount() const;
+    size_t getUploadRangeCount() const;
+
+    // Baked vertex animation. While recording, every new pose is skinned on
+    // the CPU and appended to the cache file. Playback shows cached frames
+    // in place of FK and skinning.
+    bool startCacheRecording(const std::string& path);
+    void stopCacheRecording();
+    bool isRecordingCache() const;
+    size_t getRecordedFrameCount() const;
+
+    bool openCachePlayback(const std::string& path);
+    void closeCachePlayback();
+    bool isPlayingCache() const;
+    size_t getCacheFrameCount() const;
+    size_t getCacheFrame() const;
+    void setCacheFrame(size_t frame);
+
+    // Getter and setter for running playback, and the per-frame step (wraps around)
+    bool isCachePlaybackRunning() const;
+    void setCachePlaybackRunning(bool running);
+    void stepCachePlayback();
+
+    // Keyframe animation of the skeleton; the player is bound to the clip
+    AnimationClip& getAnimationClip();
+    CompressedClip& getCompressedClip(); // Played instead when set on the player
+    AnimationPlayer& getAnimationPlayer();
+    void updateAnimation(double deltaTime); // Player, pose layers, then IK
+
+    // Pose layers, evaluated by a BlendTree in place of applying the
+    // player's pose directly. The player's pose is the base; the subtree of
+    // the upper body joint blends toward the clip played at a time offset,
+    // then takes an additive layer: the clip at the additive time against
+    // its first frame. Joints keyed by neither the player nor the clip are
+    // left alone.
+    bool isPoseLayering() const;
+    void setPoseLayering(bool enabled);
+    int getUpperBodyJoint() const;
+    void setUpperBodyJoint(int jointIndex);
+    float getUpperBodyWeight() const;
+    void setUpperBodyWeight(float weight);
+    float getUpperBodyOffset() const; // Seconds ahead of the player
+    void setUpperBodyOffset(float offset);
+    float getAdditiveWeight() const;
+    void setAdditiveWeight(float weight);
+    float getAdditiveTime() const;
+    void setAdditiveTime(float time);
+    const BlendTree& getBlendTree() const;
+    double getBlendTime() const; // Milliseconds for the last evaluation
+    void markClipChanged(); // Call after editing the clip, so the layers are rebuilt from it
+
+    // Animation, pose layers, IK, FK, jiggle bones and the skinning palette.
+    // Makes no GL calls and touches nothing outside this character, so
+    // PoseStage can run it for many characters in parallel; draw() then
+    // only skins and uploads.
+    void updatePose(double deltaTime);
+
+    // Long takes on disk. Export samples the clip at a fixed rate; an open
+    // stream is played in place of the clip and paged in around the playhead.
+    bool exportAnimationStream(const std::string& path, float sampleRate = STREAM_SAMPLE_RATE);
+    bool openAnimationStream(const std::string& path);
+    void closeAnimationStream();
+    AnimationStream& getAnimationStream();
+
+    // IK chains, solved in order by updateAnimation() after the clip is applied
+    std::vector<IKChain>& getIKChains();
+    double getIKSolveTime() const; // Milliseconds for all chains in the last update
+
+    // Secondary motion, simulated by updatePose() after FK
+    JiggleBones& getJiggleBones();
+
+    // Getter and setter for multithreaded skinning on the shared WorkerPool
+    bool isParallelSkinning() const;
+    void setParallelSkinning(bool enabled);
+
+    // Update vertices for SSD, skipped while the pose version is unchanged
     void updateMeshVertices(); 
     void resetPose();
 
@@ -62,23 +217,105 @@ private:
                          std::vector<glm::vec3>& boneNormals,
                          std::vector<glm::uvec3>& boneFaces);
 
-    // Current vertex positions after animation
-    std::vector<glm::vec3> bindVertices; // Initial vertex positions
+    // Bind mesh, faces, attachment weights, the SIMD kernel layout and the
+    // static GPU buffer, shared with every character imported from the same
+    // files. Shape's vertices hold this character's skinned positions; its
+    // faces and normals stay empty.
+    std::shared_ptr<const CharacterAsset> asset;
 
-    // List of vertex to joint attachments
-    // each element of attachments is a vector< float > containing
-    // one attachment weight per joint
-    std::vector<std::vector<float>> attachments; // Attachment weights
+    // Bind normals skinned alongside the positions (unnormalized, see SkinningKernel)
+    std::vector<glm::vec3> skinnedNormals;
 
     SkeletalModel m_skeletalModel;  // Directly owned skeletal model
+
+    SkinningBackend skinningBackend = CPU_SIMD;
+    SkinningMethod skinningMethod = LINEAR_BLEND;
+    double skinningTime = 0.0;
+
+    // Level of detail state; the asset has the heaviest joint of each vertex
+    // and the bind pose bounding sphere
+    SkinningLOD skinningLOD = LOD_FULL;
+    bool automaticLOD = true;
+    float projectedSize = 0.0f;
+
+    // Vertices per parallel skinning job, a multiple of SkinningKernel::SORT_WINDOW
+    static const size_t SKINNING_CHUNK_SIZE = 1024;
+    bool parallelSkinning = false;
+
+    // Skin vertices [begin, end) into vertices and skinnedNormals with the current palette
+    void skinVertexRange(size_t begin, size_t end);
+
+    // Re-skin only the vertices weighted to joints that changed since
+    // meshPoseVersion and upload the matching VBO ranges. Returns false
+    // when a full pass is needed instead.
+    bool skinChangedVertices();
+    std::vector<unsigned char> vertexAffected;
+    std::vector<float> meshVertexData;   // CPU copy of meshVBO
+
+    // Drop the CPU skinning buffers while the GPU path draws the mesh
+    void releaseMeshBuffer();
+    size_t reskinnedVertexCount = 0;
+    size_t uploadRangeCount = 0;
+
+    static const int MESH_CORNER_FLOATS = 9;             // Position, normal, color
+    static const size_t MAX_UPLOAD_GAP_FACES = 32;       // Unchanged faces merged into an upload range
+
+    // Per-frame palette for the GPU backend; the static attributes are the asset's
+    GLuint skinningShaderProgram = 0;
+    unsigned long palettePoseVersion = 0; // Pose version held by paletteUBO
+    void uploadJointPalette();
+
+    AnimationClip animationClip;
+    CompressedClip compressedClip;
+    AnimationPlayer animationPlayer;
+    AnimationStream animationStream;
+    static constexpr float STREAM_SAMPLE_RATE = 60.0f; // Frames per second
+
+    // Pose layers: nodes of blendTree, rebuilt when the layout changes
+    BlendTree blendTree;
+    bool poseLayering = false;
+    bool blendTreeDirty = true; // Rebuild before the next evaluation
+    bool blendWeightsDirty = false; // Evaluate even if the player did not step
+    int upperBodyJoint = 0;
+    float upperBodyWeight = 1.0f;
+    float upperBodyOffset = 0.5f;
+    float additiveWeight = 0.0f;
+    float additiveTime = 0.0f;
+    int baseNode = -1, upperBodyNode = -1, additiveNode = -1, upperBodyBlendNode = -1, layeredNode = -1;
+    AnimationClip::Cursor upperBodyCursor;
+    double blendTime = 0.0;
+
+    // Build the tree and the additive pose for the current settings, then
+    // evaluate it and pose the skeleton
+    void buildBlendTree();
+    void evaluateBlendTree();
+
+    std::vector<IKChain> ikChains;
+    double ikSolveTime = 0.0;
+
+    JiggleBones jiggleBones;
+
+    // Vertex cache recording and playback
+    VertexCacheWriter cacheWriter;
+    VertexCache vertexCache;
+    size_t cacheFrame = 0;
+    bool cachePlaybackRunning = false;
+    static const int CACHE_POSITION_STEPS = 65535; // Quantization steps across the bind pose diameter
+
+    // Pose version the display buffers were last built for; meshDirty forces
+    // a rebuild after anything other than the pose changes
+    unsigned long meshPoseVersion = 0;
+    bool meshDirty = true;
 	
     DisplayMode displayMode = MESH;  // Default to skeletal mode
 
     GLuint meshVAO, meshVBO, meshEBO;
     GLuint jointVAO, jointVBO, jointEBO;
     GLuint boneVAO, boneVBO, boneEBO;
+    GLuint paletteUBO, dualQuaternionUBO;
 
     float jointIndexCount, boneIndexCount;
+    size_t meshCornerCount = 0, jointVertexCount = 0, boneVertexCount = 0; // Sizes of the live VBOs
 
     Joint* findParent(Joint* child); 
 };
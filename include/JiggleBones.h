@@ -0,0 +1,133 @@
+#ifndef JIGGLEBONES_H
+#define JIGGLEBONES_H
+
+#include "SkeletalModel.h"
+#include "SkinningKernel.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <vector>
+#include <cstddef>
+
+// Secondary motion for selected joints (hair, cloth tabs, belly). Each
+// jiggle joint is a Verlet particle pulled toward where the animation puts
+// the joint by a spring, damped, and pulled by gravity; its parent is then
+// turned so the joint sits on the particle at its animated bone length.
+//
+// update() runs after FK and before the palette is used. The particles are
+// kept as structure-of-arrays and stepped with SSE4/AVX2, LANE_COUNT at a
+// time, at FIXED_SUBSTEP however often update() is called. The animated
+// position is interpolated across the sub-steps of one update. A character
+// whose particles have come to rest and whose pose has not changed skips
+// the update entirely, so a standing crowd costs nothing.
+//
+// Particles live in the skeleton's model space: moving the character as a
+// whole does not swing them, animating it does. Each parent drives one
+// jiggle joint, so two siblings cannot both jiggle.
+
+class JiggleBones {
+public:
+    static const double FIXED_SUBSTEP;            // Seconds
+    static const int MAX_SUBSTEPS_PER_UPDATE = 8; // Longer stalls drop time instead of catching up
+    static const int LANE_COUNT = 8;              // Particles are padded to a multiple of this
+
+    static constexpr float DEFAULT_STIFFNESS = 150.0f; // Spring toward the animated position, 1/s^2
+    static constexpr float MAX_STIFFNESS = 2000.0f;    // Keeps the explicit step stable
+    static constexpr float DEFAULT_DAMPING = 0.05f;    // Fraction of velocity lost per sub-step
+    static constexpr float SLEEP_DISTANCE = 1e-5f;     // Model units moved per update below which particles rest
+
+    JiggleBones();
+
+    // Make jointIndex jiggle by turning its parent. Returns false if the
+    // joint has no parent, already jiggles or has a sibling that does.
+    bool addJoint(const SkeletalModel& model, int jointIndex,
+                  float stiffness = DEFAULT_STIFFNESS, float damping = DEFAULT_DAMPING);
+
+    // Give the parent back its animated rotation and stop simulating the joint
+    bool removeJoint(SkeletalModel& model, int jointIndex);
+    void clear(SkeletalModel& model);
+
+    // Jiggle joints in evaluation order (parents before children)
+    const std::vector<int>& getJoints() const;
+    bool isEmpty() const;
+
+    // Getters and setters for a jiggle joint's spring; i indexes getJoints()
+    float getStiffness(size_t i) const;
+    void setStiffness(size_t i, float stiffness);
+    float getDamping(size_t i) const;
+    void setDamping(size_t i, float damping);
+
+    // Getter and setter for gravity, in model units/s^2
+    glm::vec3 getGravity() const;
+    void setGravity(const glm::vec3& gravity);
+
+    // Getter and setter for the stepping path; clamped to what the CPU supports
+    SkinningKernel::InstructionSet getInstructionSet() const;
+    void setInstructionSet(SkinningKernel::InstructionSet set);
+
+    // Snap the particles to the animated pose on the next update()
+    void reset();
+
+    // Step the particles by deltaTime and pose the parents. The model is left
+    // with its world transforms and palette up to date.
+    void update(SkeletalModel& model, double deltaTime);
+
+    // Results of the last update()
+    int getSubstepCount() const;
+    bool isSleeping() const;
+    double getTime() const; // Milliseconds
+
+    size_t getMemoryUsage() const; // Approximate heap usage in bytes
+
+private:
+    std::vector<int> joints;  // Jiggle joints, in evaluation order
+    std::vector<int> parents; // The joint each one turns
+
+    // Rotation of each parent as the animation left it, and as update() set it
+    std::vector<glm::quat> animatedRotations;
+    std::vector<glm::quat> appliedRotations;
+    std::vector<float> boneLengths; // Animated, read every update
+
+    // Per lane, padded to a multiple of LANE_COUNT: current and previous
+    // particle positions, the animated position now and at the last
+    // sub-step, and the spring
+    std::vector<float> positionX, positionY, positionZ;
+    std::vector<float> previousX, previousY, previousZ;
+    std::vector<float> targetX, targetY, targetZ;
+    std::vector<float> lastTargetX, lastTargetY, lastTargetZ;
+    std::vector<float> stiffness, damping;
+
+    glm::vec3 gravity;
+    SkinningKernel::InstructionSet instructionSet;
+
+    std::vector<glm::vec3> startPositions; // Particles before this update's sub-steps, for the sleep test
+
+    double accumulator; // Elapsed time not yet consumed by a sub-step
+    bool needsReset;
+    bool sleeping;
+    unsigned long appliedPoseVersion; // Pose version update() left the model at
+
+    int substepCount;
+    double time;
+
+    // Insert or remove lane i in every lane array, keeping the padding
+    void insertLane(size_t i, float stiffness, float damping);
+    void eraseLane(size_t i);
+    std::vector<std::vector<float>*> getLaneArrays();
+
+    // Each runs steps sub-steps on every lane, moving the animated position
+    // from lastTarget to target
+    void stepScalar(int steps);
+    void stepSSE4(int steps);
+    void stepAVX2(int steps);
+
+    // Give each parent back its animated rotation, or take a rotation the
+    // animation set since as the new animated one
+    void restoreAnimatedRotations(SkeletalModel& model);
+
+    // Hold each particle at its bone length from the parent and turn the parent onto it
+    void applyRotations(SkeletalModel& model);
+};
+
+#endif // JIGGLEBONES_H
@@ -0,0 +1,41 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <string>
+#include <cstddef>
+
+// Read-only memory-mapped file. The OS pages the contents in on demand and
+// may drop them again under memory pressure, so a file larger than RAM can
+// still be read front to back.
+
+class MappedFile {
+public:
+    MappedFile();
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // sequential: mostly read front to back; otherwise random access
+    bool open(const std::string& path, bool sequential = true);
+    void close();
+
+    bool isOpen() const;
+    const unsigned char* getData() const;
+    size_t getSize() const;
+
+    // Hint that [offset, offset + length) will be read soon
+    void prefetch(size_t offset, size_t length) const;
+
+    // Fault [offset, offset + length) in now, blocking until it is resident
+    void load(size_t offset, size_t length) const;
+
+    // Let the OS drop the pages that lie wholly inside [offset, offset + length)
+    void release(size_t offset, size_t length) const;
+
+private:
+    void* data;
+    size_t size;
+};
+
+#endif // MAPPEDFILE_H
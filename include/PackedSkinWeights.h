@@ -0,0 +1,72 @@
+#ifndef PACKEDSKINWEIGHTS_H
+#define PACKEDSKINWEIGHTS_H
+
+#include "SkinWeights.h"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <cstddef>
+
+// Compact skin weights: a fixed number of slots per vertex, each an 8-bit
+// joint index and an 8- or 16-bit unorm weight. Only the maxInfluences
+// heaviest influences of a vertex are kept, renormalized, then rounded so
+// the integer weights of a vertex sum exactly to the unorm maximum.
+//
+// With the default 4 slots that is 8 (UNORM8) or 12 (UNORM16) bytes per
+// vertex. Unused slots hold joint 0 with weight 0.
+
+class PackedSkinWeights {
+public:
+    enum Precision { UNORM8 = 8, UNORM16 = 16 };
+
+    static const int DEFAULT_MAX_INFLUENCES = 4;
+    static const int MAX_JOINTS = 256; // Joint indices are 8 bits
+
+    PackedSkinWeights();
+
+    // Prune and quantize. Returns false (and stays empty) if a joint index
+    // does not fit in 8 bits.
+    bool pack(const SkinWeights& weights, int maxInfluences = DEFAULT_MAX_INFLUENCES, Precision precision = UNORM8);
+    void clear();
+
+    // Expand into CSR form for the skinning loops, dropping the empty slots
+    void unpack(SkinWeights& out) const;
+
+    bool isEmpty() const;
+    size_t getVertexCount() const;
+    size_t getJointCount() const;
+    int getMaxInfluences() const;
+    Precision getPrecision() const;
+
+    // Slot k of vertex v is at v * getMaxInfluences() + k
+    const std::vector<unsigned char>& getJoints() const;
+    const std::vector<unsigned char>& getWeights8() const;   // UNORM8 only
+    const std::vector<unsigned short>& getWeights16() const; // UNORM16 only
+    float getWeight(size_t vertex, int slot) const;
+
+    size_t getBytesPerVertex() const;
+    size_t getMemoryUsage() const;
+
+    // Round weights summing to 1 to integers summing exactly to maxValue,
+    // giving the leftover units to the largest remainders
+    static void quantizeWeights(const float* weights, int count, unsigned int maxValue, unsigned int* out);
+
+    // Largest distance between the vertices skinned (linear blend) with the
+    // two weight sets under the given palette
+    static float computeMaxPositionError(const SkinWeights& reference, const SkinWeights& approximation,
+                                         const std::vector<glm::vec3>& bindVertices,
+                                         const std::vector<glm::mat4>& palette);
+
+private:
+    size_t vertexCount;
+    size_t jointCount;
+    int maxInfluences;
+    Precision precision;
+
+    std::vector<unsigned char> joints;
+    std::vector<unsigned char> weights8;
+    std::vector<unsigned short> weights16;
+};
+
+#endif // PACKEDSKINWEIGHTS_H
@@ -0,0 +1,70 @@
+#ifndef POSEBUFFER_H
+#define POSEBUFFER_H
+
+#include "SkeletalModel.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <vector>
+#include <cstddef>
+
+// Local pose of every joint of a skeleton (translation, rotation, scale) in
+// structure-of-arrays form: one float array per component. The blend
+// operators run over whole buffers, 4 joints per SSE iteration with a
+// scalar loop for the remainder, and never branch per joint.
+//
+// Rotations are blended by normalized lerp in the hemisphere of the first
+// pose. Operators may write into one of their inputs.
+
+class PoseBuffer {
+public:
+    PoseBuffer();
+    explicit PoseBuffer(size_t jointCount);
+
+    size_t getJointCount() const;
+    void resize(size_t jointCount); // New joints get the identity pose
+    void setIdentity();
+
+    size_t getMemoryUsage() const; // Approximate heap usage in bytes
+
+    glm::vec3 getTranslation(size_t joint) const;
+    void setTranslation(size_t joint, const glm::vec3& translation);
+    glm::quat getRotation(size_t joint) const;
+    void setRotation(size_t joint, const glm::quat& rotation);
+    glm::vec3 getScale(size_t joint) const;
+    void setScale(size_t joint, const glm::vec3& scale);
+
+    // Copy the local pose of every joint from or to a skeleton
+    void capture(const SkeletalModel& model);
+    void apply(SkeletalModel& model) const;
+
+    // out = a + weight * (b - a)
+    static void blend(const PoseBuffer& a, const PoseBuffer& b, float weight, PoseBuffer& out);
+
+    // As blend(), with the weight of joint j scaled by mask[j]
+    static void maskedBlend(const PoseBuffer& a, const PoseBuffer& b, const std::vector<float>& mask,
+                            float weight, PoseBuffer& out);
+
+    // Difference of pose from reference, for use as an additive layer
+    static void makeAdditive(const PoseBuffer& pose, const PoseBuffer& reference, PoseBuffer& out);
+
+    // Apply an additive layer on top of base, scaled by weight and an
+    // optional per-joint mask (nullptr for none)
+    static void addLayer(const PoseBuffer& base, const PoseBuffer& additive, float weight,
+                         const std::vector<float>* mask, PoseBuffer& out);
+
+private:
+    enum Channel { TX, TY, TZ, QX, QY, QZ, QW, SX, SY, SZ, CHANNEL_COUNT };
+
+    size_t jointCount;
+    std::vector<float> channels[CHANNEL_COUNT];
+
+    float* channel(Channel c);
+    const float* channel(Channel c) const;
+
+    // Shared by blend() and maskedBlend(); mask may be null
+    static void blendPoses(const PoseBuffer& a, const PoseBuffer& b, const float* mask, float weight, PoseBuffer& out);
+};
+
+#endif // POSEBUFFER_H
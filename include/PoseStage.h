@@ -0,0 +1,41 @@
+#ifndef POSESTAGE_H
+#define POSESTAGE_H
+
+#include "ImportCharacter.h"
+#include "Shape.h"
+
+#include <vector>
+#include <cstddef>
+
+// Scene-level pose update, run once per frame before anything is drawn.
+// Every character's clip playback, pose layers, IK, FK and skinning palette are
+// evaluated here, in parallel across characters on the shared WorkerPool;
+// draw() then finds its skeleton up to date and only skins and uploads.
+//
+// Characters are claimed one chunk at a time from the pool's shared
+// counter, so a thread that finishes early takes the next rig instead of
+// idling behind a slow one. No GL calls are made from this stage.
+
+class PoseStage {
+public:
+    static const size_t CHARACTERS_PER_CHUNK = 1;
+
+    PoseStage();
+
+    // Update every ImportCharacter among shapes; returns once all are done
+    void run(const std::vector<Shape*>& shapes, double deltaTime);
+
+    bool isParallel() const;
+    void setParallel(bool parallel);
+
+    // Characters and milliseconds of the last run()
+    size_t getCharacterCount() const;
+    double getTime() const;
+
+private:
+    std::vector<ImportCharacter*> characters;
+    bool parallel;
+    double time;
+};
+
+#endif // POSESTAGE_H
@@ -22,6 +22,8 @@
 #include "Sphere.h"
 #include "Teapot.h"
 #include "FileImporter.h"
+#include "PoseStage.h"
+#include "CrowdRenderer.h"
 
 class Renderer {
 public:
@@ -30,6 +32,8 @@ public:
     // Shader utilities
     GLuint getShaderProgram() const;
     void setShaderProgram(GLuint shader);
+    GLuint getSkinningShaderProgram() const;
+    void setSkinningShaderProgram(GLuint shader);
 
     // Public methods for controlling the rendering pipeline
     void setupLighting(GLuint shaderProg);
@@ -57,6 +61,36 @@ private:
     bool showAxis = true;
 
     GLuint shaderProgram; // Holds the active shader program
+    GLuint skinningShaderProgram = 0; // GPU skinning variant, 0 if it failed to build
+
+    // Skin weight compression applied to imported characters
+    int skinInfluenceLimit = PackedSkinWeights::DEFAULT_MAX_INFLUENCES;
+    int skinWeightPrecision = 0; // 0 = 8-bit, 1 = 16-bit
+
+    // Clip time the next "Add Keyframe" records at
+    float keyframeTime = 0.0f;
+
+    // Clip compression tolerance and the error measured after compressing
+    float clipTolerance = CompressedClip::DEFAULT_TOLERANCE;
+    float clipCompressionError = 0.0f;
+
+    // Poses every character before the draw loop
+    PoseStage poseStage;
+
+    // Instanced drawing of GPU-skinned characters, and how many copies of
+    // the selected character "Add Copies" creates
+    CrowdRenderer crowdRenderer;
+    int crowdCopies = 100;
+
+    // Settings for the next IK chain; the budget applies to every chain
+    int ikEndJoint = 0;
+    int ikBoneCount = 2;
+    int ikMethod = IKChain::FABRIK;
+    int ikMaxIterations = IKChain::DEFAULT_MAX_ITERATIONS;
+    float ikTolerance = IKChain::DEFAULT_TOLERANCE;
+
+    // Joint the next "Add Jiggle" makes jiggle
+    int jiggleJoint = 0;
 
 };
 
@@ -3,6 +3,7 @@
 
 #include "MatrixStack.h"
 #include "Joint.h"
+#include "DualQuaternion.h"
 
 #include "glad/glad.h"
 #include <GLFW/glfw3.h>
@@ -10,8 +11,10 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
+#include <glm/gtc/quaternion.hpp>
 
 #include <vector>
+#include <unordered_map>
 
 class SkeletalModel {
 public:
@@ -29,11 +32,64 @@ public:
 
     MatrixStack& getMatrixStack();
 
+    // Rotate a joint by Euler angles in degrees, applied X, then Y, then Z
+    // in the joint's frame. Only the joint's rotation changes; its
+    // translation and scale are kept.
     void setJointTransform(int jointIndex, float rX, float rY, float rZ);
 
+    // The rotation setJointTransform() applies, built directly from half-angle
+    // sines and cosines instead of three matrix rotations
+    static glm::quat eulerToQuaternion(float rX, float rY, float rZ);
+
+    // Inverse of eulerToQuaternion(), in degrees
+    static glm::vec3 quaternionToEuler(const glm::quat& rotation);
+
+    // Local pose of a joint relative to its parent, as used by animation
+    glm::quat getJointRotation(int jointIndex) const;
+    void setJointRotation(int jointIndex, const glm::quat& rotation);
+    glm::vec3 getJointTranslation(int jointIndex) const;
+    void setJointTranslation(int jointIndex, const glm::vec3& translation);
+    glm::vec3 getJointScale(int jointIndex) const;
+    void setJointScale(int jointIndex, const glm::vec3& scale);
+
+    // Pose version, bumped whenever a joint transform or the hierarchy changes.
+    // Call markPoseChanged() after editing a Joint directly.
+    unsigned long getPoseVersion() const;
+    void markPoseChanged();
+
+    // Pose version at which each joint's palette entry last changed. A joint
+    // changes with its own transform or any ancestor's, so consumers that
+    // remember the version they last saw can find the joints that moved since.
+    const std::vector<unsigned long>& getJointChangeVersions() const;
+
+    // Index of each joint's parent in getJoints(), -1 for the root
+    const std::vector<int>& getParentIndices() const;
+
+    // Joint indices with every parent before its children
+    const std::vector<int>& getEvaluationOrder() const;
+
+    // Current joint --> world transform of a joint, from the flat skeleton
+    const glm::mat4& getJointToWorldTransform(int jointIndex) const;
+
     void computeBindWorldToJointTransforms();
+
+    // Recomputes only the subtrees under joints changed by setJointTransform();
+    // markPoseChanged() recomputes everything. No-op while the pose version is unchanged.
     void updateCurrentJointToWorldTransforms();
 
+    // Joints recomputed by the last updateCurrentJointToWorldTransforms() that did work
+    size_t getUpdatedJointCount() const;
+
+    // Skinning palette: one currentJointToWorld * bindWorldToJoint matrix per joint,
+    // rebuilt by updateCurrentJointToWorldTransforms()
+    const std::vector<glm::mat4>& getSkinningPalette() const;
+    void updateSkinningPalette();
+
+    // The same transforms as unit dual quaternions, for dual quaternion skinning
+    const std::vector<DualQuaternion>& getDualQuaternionPalette() const;
+
+    // Approximate heap usage in bytes, the joints included
+    size_t getMemoryUsage() const;
 
 private:   
     std::vector<Joint*> m_joints;
@@ -41,10 +97,43 @@ private:
     MatrixStack m_matrixStack;
     std::vector<glm::vec3> jointCenters;
     std::vector<std::pair<glm::vec3, glm::vec3>> bonePairs;    
+    std::vector<glm::mat4> m_skinningPalette;
+    std::vector<DualQuaternion> m_dualQuaternionPalette;
+    unsigned long m_poseVersion;
+    unsigned long m_evaluatedPoseVersion; // Pose version of the current transforms and palette
+    std::vector<int> m_parentIndices;
+    std::vector<unsigned char> m_jointDirty; // Local transform changed since the last evaluation
+    std::vector<unsigned long> m_jointChangeVersions;
+
+    // Flat copy of the hierarchy in parent-before-child (depth-first) order.
+    // Slot s holds joint m_flatJoints[s]; its parent slot is always below s,
+    // except for roots, whose parent is the identity entry at the end of
+    // m_worldTransforms. That way FK needs no special case for the root.
+    std::vector<int> m_flatJoints;
+    std::vector<int> m_flatParents;
+    std::vector<int> m_jointSlots;               // Slot of each joint in m_joints
+    std::vector<int> m_subtreeSizes;             // Slots s .. s + size - 1 are the subtree of s
+
+    // Local pose per slot as translation, unit rotation and scale. The
+    // matrix is composed during FK; m_localTransforms keeps the last one,
+    // which is also written back to the Joint.
+    std::vector<glm::vec3> m_localTranslations;
+    std::vector<glm::quat> m_localRotations;
+    std::vector<glm::vec3> m_localScales;
+    std::vector<glm::mat4> m_localTransforms;
+    std::vector<glm::mat4> m_worldTransforms;    // Per slot, plus the identity entry
+    std::vector<glm::mat4> m_inverseBindTransforms;
+    bool m_localTransformsStale; // Joints may have been edited directly
+    size_t m_updatedJointCount;
+
+    void markJointChanged(int jointIndex);
+    void updateParentIndices();
+
+    void buildFlatSkeleton();
+    void gatherLocalTransforms();
+    void forwardKinematics(size_t beginSlot, size_t endSlot);
+    void updateSkinningPalette(size_t beginSlot, size_t endSlot);
 
-    void bindWorldToJointTransformRecursive(Joint* joint, MatrixStack& myStack);
-    void currentJointToWorldTransformsRecursive(Joint* joint, MatrixStack& myStack);     
- 
 };
 
 #endif
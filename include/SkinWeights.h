@@ -0,0 +1,61 @@
+#ifndef SKINWEIGHTS_H
+#define SKINWEIGHTS_H
+
+#include <vector>
+#include <cstddef>
+
+// Compressed sparse row (CSR) storage for vertex to joint attachment weights.
+// Only the non-zero influences are kept: the influences of vertex i are
+// influences[offsets[i]] .. influences[offsets[i + 1] - 1].
+//
+// The transpose is kept too: the vertices weighted to joint j are
+// jointVertices[jointOffsets[j]] .. jointVertices[jointOffsets[j + 1] - 1].
+
+class SkinWeights {
+public:
+    struct Influence {
+        int jointIndex;
+        float weight;
+    };
+
+    SkinWeights();
+
+    // Build from dense attachments (one weight per joint per vertex)
+    void setFromDense(const std::vector<std::vector<float>>& attachments);
+
+    // Build from CSR arrays directly; jointCount sizes the joint index
+    void setFromSparse(const std::vector<unsigned int>& offsets, const std::vector<Influence>& influences, size_t jointCount);
+    void clear();
+
+    // Raw CSR arrays for the skinning loops
+    const std::vector<unsigned int>& getOffsets() const;
+    const std::vector<Influence>& getInfluences() const;
+
+    // Joint to vertex index, for finding the vertices a joint moves
+    const std::vector<unsigned int>& getJointOffsets() const;
+    const std::vector<unsigned int>& getJointVertices() const;
+    size_t getJointCount() const;
+
+    size_t getVertexCount() const;
+    size_t getInfluenceCount() const;
+    int getMaxInfluencesPerVertex() const;
+
+    // Up to maxCount largest influences of a vertex, heaviest first and
+    // renormalized to sum to 1. Returns how many were written to out.
+    int getLargestInfluences(size_t vertex, int maxCount, Influence* out) const;
+
+    // Approximate heap usage in bytes
+    size_t getMemoryUsage() const;
+
+private:
+    std::vector<unsigned int> offsets;   // vertexCount + 1 entries
+    std::vector<Influence> influences;   // (jointIndex, weight) pairs
+    std::vector<unsigned int> jointOffsets;  // jointCount + 1 entries
+    std::vector<unsigned int> jointVertices; // Vertex indices grouped by joint
+    int maxInfluencesPerVertex;
+
+    // Transpose influences into jointOffsets / jointVertices
+    void buildJointIndex(size_t jointCount);
+};
+
+#endif // SKINWEIGHTS_H
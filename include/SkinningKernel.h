@@ -0,0 +1,97 @@
+#ifndef SKINNINGKERNEL_H
+#define SKINNINGKERNEL_H
+
+#include "SkinWeights.h"
+#include "DualQuaternion.h"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <cstddef>
+
+// Vectorized linear blend skinning.
+//
+// Bind positions and normals are kept in structure-of-arrays form and the influences are
+// repacked into fixed slots per block of 8 vertices, so AVX2 skins 8 vertices
+// and SSE4 skins 4 vertices per iteration against the joint palette. The
+// instruction set is picked at runtime from what the CPU supports, with a
+// scalar loop over the same layout as the fallback.
+//
+// Within each window of SORT_WINDOW vertices the vertices are ordered by
+// influence count, so a block only runs as many slots as its busiest vertex
+// and little work is spent on zero padding. Each vertex's slots are ordered
+// by descending weight, so slot 0 holds its heaviest joint.
+//
+// Normals are skinned in the same pass from the palette entries already
+// loaded for the position. They are written unnormalized (linear blending
+// shortens them); the fragment shader normalizes.
+//
+// Results match the ImportCharacter scalar path to within SKINNING_TOLERANCE
+// (absolute, model units); the difference comes only from fused multiply-add
+// and summation order. tests/SimdConsistencyTest checks every path.
+
+class SkinningKernel {
+public:
+    enum InstructionSet { SCALAR, SSE4, AVX2 };
+
+    static const int BLOCK_SIZE = 8;
+    static const int SORT_WINDOW = 128;
+    static constexpr float SKINNING_TOLERANCE = 1e-5f;
+
+    SkinningKernel();
+
+    // Repack bind positions, normals and attachment weights into the SoA layout
+    void setup(const std::vector<glm::vec3>& bindVertices, const std::vector<glm::vec3>& bindNormals,
+               const SkinWeights& weights);
+
+    // Skin vertices [begin, end) with the given palette, writing positions to
+    // out[begin, end) and normals to outNormals[begin, end)
+    void skin(const std::vector<glm::mat4>& palette, size_t begin, size_t end, glm::vec3* out, glm::vec3* outNormals) const;
+
+    // Dual quaternion skinning over the same layout. Quaternions are blended
+    // in the hemisphere of the heaviest joint.
+    void skinDualQuaternion(const std::vector<DualQuaternion>& palette, size_t begin, size_t end, glm::vec3* out, glm::vec3* outNormals) const;
+
+    size_t getVertexCount() const;
+    size_t getMemoryUsage() const; // Approximate heap usage in bytes
+
+    InstructionSet getInstructionSet() const;
+    void setInstructionSet(InstructionSet set); // Clamped to what the CPU supports
+
+    static InstructionSet detectInstructionSet();
+    static const char* getInstructionSetName(InstructionSet set);
+
+private:
+    size_t vertexCount;
+    size_t blockCount;
+    int slotCount; // Influence slots per vertex (max influences of any vertex)
+
+    // Per lane, in sorted order and padded to a whole window
+    std::vector<unsigned int> laneVertex; // Original vertex index, vertexCount for padding
+    std::vector<float> bindX, bindY, bindZ;
+    std::vector<float> normalX, normalY, normalZ;
+
+    // Per block: blockSlots[b] used slots, then slotCount * BLOCK_SIZE joint/weight lanes
+    std::vector<int> blockSlots;
+    std::vector<int> slotJoints;
+    std::vector<float> slotWeights;
+
+    InstructionSet instructionSet;
+
+    // Each skins the blocks [firstBlock, lastBlock) and writes the vertices that fall in [begin, end)
+    void skinScalar(const float* palette, size_t firstBlock, size_t lastBlock, size_t begin, size_t end, glm::vec3* out, glm::vec3* outNormals) const;
+    void skinSSE4(const float* palette, size_t firstBlock, size_t lastBlock, size_t begin, size_t end, glm::vec3* out, glm::vec3* outNormals) const;
+    void skinAVX2(const float* palette, size_t firstBlock, size_t lastBlock, size_t begin, size_t end, glm::vec3* out, glm::vec3* outNormals) const;
+
+    void skinDualQuaternionScalar(const float* palette, size_t firstBlock, size_t lastBlock, size_t begin, size_t end, glm::vec3* out, glm::vec3* outNormals) const;
+    void skinDualQuaternionSSE4(const float* palette, size_t firstBlock, size_t lastBlock, size_t begin, size_t end, glm::vec3* out, glm::vec3* outNormals) const;
+    void skinDualQuaternionAVX2(const float* palette, size_t firstBlock, size_t lastBlock, size_t begin, size_t end, glm::vec3* out, glm::vec3* outNormals) const;
+
+    // Blocks [firstBlock, lastBlock) of the windows covering vertices [begin, end)
+    void getBlockRange(size_t begin, size_t end, size_t& firstBlock, size_t& lastBlock) const;
+
+    void storeBlock(const float* x, const float* y, const float* z, const float* nx, const float* ny, const float* nz,
+                    size_t block, size_t begin, size_t end, glm::vec3* out, glm::vec3* outNormals) const;
+};
+
+#endif // SKINNINGKERNEL_H
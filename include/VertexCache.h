@@ -0,0 +1,77 @@
+#ifndef VERTEXCACHE_H
+#define VERTEXCACHE_H
+
+#include "MappedFile.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Baked vertex animation, played back from a memory-mapped file.
+//
+// Each frame stores per vertex a position quantized to multiples of
+// positionStep and an octahedral-encoded normal scaled to +-NORMAL_SCALE.
+// The five integers are stored as the difference from the previous frame,
+// zigzag encoded into variable-length bytes, so slow motion costs one or two
+// bytes per component. Every keyframeInterval-th frame is stored against
+// zero so playback can seek without decoding from the start.
+//
+// Layout: Header, frame data, padding to 8 bytes, then frameCount + 1
+// uint64 frame offsets (the last one is the end of the frame data).
+
+class VertexCache {
+public:
+    struct Header {
+        char magic[4];
+        uint32_t version;
+        uint32_t vertexCount;
+        uint32_t frameCount;
+        uint32_t keyframeInterval;
+        float positionStep;
+        uint64_t indexOffset;
+    };
+
+    static const uint32_t VERSION = 1;
+    static const int COMPONENTS = 5;              // Position x, y, z, normal u, v
+    static const int NORMAL_SCALE = 511;
+    static const uint32_t DEFAULT_KEYFRAME_INTERVAL = 30;
+    static const size_t PREFETCH_FRAMES = 8;      // Frames paged in ahead of playback
+
+    VertexCache();
+
+    bool open(const std::string& path);
+    void close();
+    bool isOpen() const;
+
+    size_t getVertexCount() const;
+    size_t getFrameCount() const;
+    float getPositionStep() const;
+    size_t getFileSize() const;
+
+    // Decode one frame. Moving forward continues from the last decoded frame;
+    // anything else restarts at the keyframe before it.
+    bool readFrame(size_t frame, glm::vec3* positions, glm::vec3* normals);
+
+    // Shared with VertexCacheWriter
+    static bool isValidHeader(const Header& header);
+    static void fillHeader(Header& header, uint32_t vertexCount, uint32_t frameCount,
+                           uint32_t keyframeInterval, float positionStep, uint64_t indexOffset);
+    static unsigned char* writeVarint(int32_t value, unsigned char* out);
+    static const unsigned char* readVarint(const unsigned char* in, const unsigned char* end, int32_t& value);
+    static void encodeNormal(const glm::vec3& normal, int32_t& u, int32_t& v);
+    static glm::vec3 decodeNormal(int32_t u, int32_t v);
+
+private:
+    MappedFile file;
+    Header header;
+
+    std::vector<int32_t> state; // Quantized values of decodedFrame
+    size_t decodedFrame;        // frameCount when nothing is decoded
+
+    uint64_t getFrameOffset(size_t frame) const;
+    bool decodeFrame(size_t frame);
+};
+
+#endif // VERTEXCACHE_H
@@ -0,0 +1,48 @@
+#ifndef VERTEXCACHEWRITER_H
+#define VERTEXCACHEWRITER_H
+
+#include "VertexCache.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Records frames into the VertexCache format. Each frame is encoded and
+// written as it arrives; only the previous frame and the frame offsets are
+// kept in memory.
+
+class VertexCacheWriter {
+public:
+    VertexCacheWriter();
+    ~VertexCacheWriter(); // Finishes the file if still open
+
+    VertexCacheWriter(const VertexCacheWriter&) = delete;
+    VertexCacheWriter& operator=(const VertexCacheWriter&) = delete;
+
+    bool open(const std::string& path, size_t vertexCount, float positionStep,
+              uint32_t keyframeInterval = VertexCache::DEFAULT_KEYFRAME_INTERVAL);
+
+    bool writeFrame(const glm::vec3* positions, const glm::vec3* normals);
+
+    // Write the frame index and the final header
+    bool close();
+
+    bool isOpen() const;
+    size_t getFrameCount() const;
+    uint64_t getBytesWritten() const;
+
+private:
+    std::ofstream file;
+    uint32_t vertexCount;
+    uint32_t keyframeInterval;
+    float positionStep;
+
+    std::vector<int32_t> previous;      // Quantized values of the last frame
+    std::vector<uint64_t> frameOffsets;
+    std::vector<unsigned char> buffer;  // One encoded frame
+};
+
+#endif // VERTEXCACHEWRITER_H
@@ -0,0 +1,65 @@
+#ifndef WORKERPOOL_H
+#define WORKERPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Persistent pool of worker threads for data-parallel loops.
+// The calling thread also works on the loop, and parallelFor() returns only
+// once every chunk has finished and every worker has left the loop.
+
+class WorkerPool {
+public:
+
+    // Shared pool used by the application
+    static WorkerPool& getInstance();
+
+    WorkerPool();
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    // Total threads working on a loop, including the caller (1 = serial)
+    int getThreadCount() const;
+    void setThreadCount(int count);
+
+    // Run fn(begin, end) over [0, count) in chunks of chunkSize.
+    // Only one loop runs on the pool at a time; a parallelFor() called from
+    // inside fn would deadlock on loopMutex, so it runs serially on the
+    // calling thread instead.
+    void parallelFor(size_t count, size_t chunkSize, const std::function<void(size_t, size_t)>& fn);
+
+private:
+    std::vector<std::thread> workers;
+    int threadCount;
+
+    std::mutex loopMutex;               // One loop in flight at a time
+    std::mutex mutex;
+    std::condition_variable wakeCondition;
+    std::condition_variable doneCondition;
+    unsigned long generation;
+    bool stopping;
+    int activeWorkers; // Workers inside runChunks(), under mutex
+
+    // Current loop. Written under mutex only while no worker is inside
+    // runChunks(), so a worker leaving one loop never claims a chunk of the next.
+    const std::function<void(size_t, size_t)>* loopFunction;
+    size_t loopCount;
+    size_t loopChunkSize;
+    size_t loopChunkCount;
+    std::atomic<size_t> nextChunk;
+    std::atomic<size_t> remainingChunks;
+
+    void startWorkers();
+    void stopWorkers();
+    void workerLoop();
+    void runChunks();
+};
+
+#endif // WORKERPOOL_H
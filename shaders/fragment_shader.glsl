@@ -15,6 +15,7 @@ uniform Light light;
 uniform Material material;
 uniform vec3 viewPos;
 uniform int useLighting;
+uniform int useVertexColor; // Light the per-vertex color instead of material.color (crowds)
 
 in vec3 FragPos;
 in vec3 Normal;
@@ -34,12 +35,14 @@ void main() {
     // Compute light direction
     vec3 lightDir = normalize(light.position - FragPos);
 
+    vec3 baseColor = useVertexColor != 0 ? FragColor : material.color;
+
     // Ambient component
-    vec3 ambient = light.ambient * material.color;
+    vec3 ambient = light.ambient * baseColor;
 
     // Diffuse component
     float diff = max(dot(norm, lightDir), 0.0);
-    vec3 diffuse = light.diffuse * diff * material.color;
+    vec3 diffuse = light.diffuse * diff * baseColor;
 
     // Specular component
     vec3 viewDir = normalize(viewPos - FragPos);
@@ -0,0 +1,134 @@
+#version 330 core
+
+// Skinning variant of vertex_shader.glsl: linear blend or dual quaternion.
+// Must match ImportCharacter::GPU_MAX_JOINTS
+#define MAX_JOINTS 128
+
+layout(location = 0) in vec3 aPosition;   // Bind pose position
+layout(location = 1) in vec3 aNormal;     // Bind pose normal
+layout(location = 2) in vec3 aColor;
+layout(location = 3) in uvec4 aJoints;    // Up to 4 joint indices
+layout(location = 4) in vec4 aWeights;    // Matching weights (16-bit unorm), summing to 1
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+
+// Current joint-to-world * bind world-to-joint, one per joint
+layout(std140) uniform JointPalette {
+    mat4 jointPalette[MAX_JOINTS];
+};
+
+// The same transforms as unit dual quaternions: real part, then dual part
+layout(std140) uniform JointDualQuaternions {
+    vec4 jointDualQuaternions[2 * MAX_JOINTS];
+};
+
+uniform int useDualQuaternions;
+uniform int useRigidSkinning; // Distant LOD: heaviest joint only
+
+// Crowd mode (CrowdRenderer): one instanced draw for many characters. Each
+// instance's texels start at crowdBase + gl_InstanceID * crowdStride: model
+// matrix (4), color with the rigid flag in w (1), then the palette, 4 texels
+// per matrix or 2 per dual quaternion. The uniform blocks are not read.
+uniform int useCrowd;
+uniform samplerBuffer crowdData;
+uniform int crowdBase;
+uniform int crowdStride;
+
+int instanceBase;
+
+mat4 paletteMatrix(uint joint) {
+    if (useCrowd == 0) return jointPalette[joint];
+
+    int texel = instanceBase + 5 + 4 * int(joint);
+    return mat4(texelFetch(crowdData, texel), texelFetch(crowdData, texel + 1),
+                texelFetch(crowdData, texel + 2), texelFetch(crowdData, texel + 3));
+}
+
+// Part 0 (real) or 1 (dual) of a joint's dual quaternion
+vec4 dualQuaternionPart(uint joint, uint part) {
+    if (useCrowd == 0) return jointDualQuaternions[2u * joint + part];
+    return texelFetch(crowdData, instanceBase + 5 + 2 * int(joint) + int(part));
+}
+
+out vec3 FragPos;
+out vec3 Normal;
+out vec3 FragColor;
+
+void skinLinearBlend(out vec4 skinnedPosition, out vec3 skinnedNormal) {
+    mat4 skin = aWeights.x * paletteMatrix(aJoints.x)
+              + aWeights.y * paletteMatrix(aJoints.y)
+              + aWeights.z * paletteMatrix(aJoints.z)
+              + aWeights.w * paletteMatrix(aJoints.w);
+
+    skinnedPosition = skin * vec4(aPosition, 1.0);
+    skinnedNormal = mat3(skin) * aNormal;
+}
+
+void skinDualQuaternion(out vec4 skinnedPosition, out vec3 skinnedNormal) {
+    // Influences come heaviest first; blend in the hemisphere of the first
+    vec4 pivot = dualQuaternionPart(aJoints.x, 0u);
+    vec4 real = vec4(0.0);
+    vec4 dual = vec4(0.0);
+
+    for (int i = 0; i < 4; ++i) {
+        vec4 r = dualQuaternionPart(aJoints[i], 0u);
+        vec4 d = dualQuaternionPart(aJoints[i], 1u);
+        float w = dot(r, pivot) < 0.0 ? -aWeights[i] : aWeights[i];
+        real += w * r;
+        dual += w * d;
+    }
+
+    float len = length(real);
+    real /= len;
+    dual /= len;
+
+    vec3 t = real.w * dual.xyz - dual.w * real.xyz + cross(real.xyz, dual.xyz);
+    vec3 p = aPosition + 2.0 * cross(real.xyz, cross(real.xyz, aPosition) + real.w * aPosition) + 2.0 * t;
+
+    skinnedPosition = vec4(p, 1.0);
+    skinnedNormal = aNormal + 2.0 * cross(real.xyz, cross(real.xyz, aNormal) + real.w * aNormal);
+}
+
+void main() {
+    vec4 skinnedPosition;
+    vec3 skinnedNormal;
+
+    mat4 modelMatrix = model;
+    vec3 color = aColor;
+    bool rigid = useRigidSkinning != 0;
+
+    if (useCrowd != 0) {
+        instanceBase = crowdBase + gl_InstanceID * crowdStride;
+        modelMatrix = mat4(texelFetch(crowdData, instanceBase), texelFetch(crowdData, instanceBase + 1),
+                           texelFetch(crowdData, instanceBase + 2), texelFetch(crowdData, instanceBase + 3));
+        vec4 colorAndFlags = texelFetch(crowdData, instanceBase + 4);
+        color = colorAndFlags.rgb;
+        rigid = colorAndFlags.w != 0.0;
+    }
+
+    if (rigid && useCrowd != 0 && useDualQuaternions != 0) {
+        // A crowd of dual quaternion characters only has dual quaternions
+        vec4 real = dualQuaternionPart(aJoints.x, 0u);
+        vec4 dual = dualQuaternionPart(aJoints.x, 1u);
+        vec3 t = real.w * dual.xyz - dual.w * real.xyz + cross(real.xyz, dual.xyz);
+        skinnedPosition = vec4(aPosition + 2.0 * cross(real.xyz, cross(real.xyz, aPosition) + real.w * aPosition) + 2.0 * t, 1.0);
+        skinnedNormal = aNormal + 2.0 * cross(real.xyz, cross(real.xyz, aNormal) + real.w * aNormal);
+    } else if (rigid) {
+        // Influences come heaviest first
+        mat4 skin = paletteMatrix(aJoints.x);
+        skinnedPosition = skin * vec4(aPosition, 1.0);
+        skinnedNormal = mat3(skin) * aNormal;
+    } else if (useDualQuaternions != 0) {
+        skinDualQuaternion(skinnedPosition, skinnedNormal);
+    } else {
+        skinLinearBlend(skinnedPosition, skinnedNormal);
+    }
+
+    FragPos = vec3(modelMatrix * skinnedPosition);
+    Normal = mat3(transpose(inverse(modelMatrix))) * skinnedNormal;
+    FragColor = color;
+
+    gl_Position = projection * view * vec4(FragPos, 1.0);
+}
@@ -0,0 +1,169 @@
+#include "AnimationClip.h"
+
+#include <algorithm>
+
+AnimationClip::AnimationClip() : duration(0.0f) {}
+
+void AnimationClip::clear() {
+    rotationTracks.clear();
+    translationTracks.clear();
+    keyframeTimes.clear();
+    duration = 0.0f;
+}
+
+bool AnimationClip::isEmpty() const { return keyframeTimes.empty(); }
+
+// Getters for the clip extent
+size_t AnimationClip::getJointCount() const { return rotationTracks.size(); }
+float AnimationClip::getDuration() const { return duration; }
+const std::vector<float>& AnimationClip::getKeyframeTimes() const { return keyframeTimes; }
+
+size_t AnimationClip::getMemoryUsage() const {
+    size_t bytes = rotationTracks.capacity() * sizeof(RotationTrack) + translationTracks.capacity() * sizeof(TranslationTrack) +
+                   keyframeTimes.capacity() * sizeof(float);
+    for (const RotationTrack& track : rotationTracks) {
+        bytes += track.times.capacity() * sizeof(float) + track.values.capacity() * sizeof(glm::quat);
+    }
+    for (const TranslationTrack& track : translationTracks) {
+        bytes += track.times.capacity() * sizeof(float) + track.values.capacity() * sizeof(glm::vec3);
+    }
+    return bytes;
+}
+
+size_t AnimationClip::Cursor::getMemoryUsage() const {
+    return (rotationKeys.capacity() + translationKeys.capacity()) * sizeof(size_t);
+}
+
+bool AnimationClip::hasRotationTrack(int jointIndex) const {
+    return jointIndex >= 0 && jointIndex < static_cast<int>(rotationTracks.size()) &&
+           !rotationTracks[jointIndex].times.empty();
+}
+
+bool AnimationClip::hasTranslationTrack(int jointIndex) const {
+    return jointIndex >= 0 && jointIndex < static_cast<int>(translationTracks.size()) &&
+           !translationTracks[jointIndex].times.empty();
+}
+
+// Getters for the raw keys
+const std::vector<float>& AnimationClip::getRotationKeyTimes(int jointIndex) const { return rotationTracks[jointIndex].times; }
+const std::vector<glm::quat>& AnimationClip::getRotationKeyValues(int jointIndex) const { return rotationTracks[jointIndex].values; }
+const std::vector<float>& AnimationClip::getTranslationKeyTimes(int jointIndex) const { return translationTracks[jointIndex].times; }
+const std::vector<glm::vec3>& AnimationClip::getTranslationKeyValues(int jointIndex) const { return translationTracks[jointIndex].values; }
+
+void AnimationClip::reserveJoints(size_t jointCount) {
+    if (jointCount <= rotationTracks.size()) return;
+    rotationTracks.resize(jointCount);
+    translationTracks.resize(jointCount);
+}
+
+void AnimationClip::addKeyframeTime(float time) {
+    // Keys usually arrive in time order
+    if (keyframeTimes.empty() || time > keyframeTimes.back()) {
+        keyframeTimes.push_back(time);
+        duration = time;
+        return;
+    }
+
+    auto it = std::lower_bound(keyframeTimes.begin(), keyframeTimes.end(), time);
+    if (it == keyframeTimes.end() || *it != time) keyframeTimes.insert(it, time);
+    duration = keyframeTimes.back();
+}
+
+void AnimationClip::setRotationKey(int jointIndex, float time, const glm::quat& rotation) {
+    if (jointIndex < 0) return;
+    reserveJoints(jointIndex + 1);
+
+    RotationTrack& track = rotationTracks[jointIndex];
+    if (track.times.empty() || time > track.times.back()) {
+        track.times.push_back(time);
+        track.values.push_back(rotation);
+        addKeyframeTime(time);
+        return;
+    }
+
+    auto it = std::lower_bound(track.times.begin(), track.times.end(), time);
+    size_t key = static_cast<size_t>(it - track.times.begin());
+
+    if (it != track.times.end() && *it == time) {
+        track.values[key] = rotation;
+    } else {
+        track.times.insert(it, time);
+        track.values.insert(track.values.begin() + key, rotation);
+    }
+    addKeyframeTime(time);
+}
+
+void AnimationClip::setTranslationKey(int jointIndex, float time, const glm::vec3& translation) {
+    if (jointIndex < 0) return;
+    reserveJoints(jointIndex + 1);
+
+    TranslationTrack& track = translationTracks[jointIndex];
+    if (track.times.empty() || time > track.times.back()) {
+        track.times.push_back(time);
+        track.values.push_back(translation);
+        addKeyframeTime(time);
+        return;
+    }
+
+    auto it = std::lower_bound(track.times.begin(), track.times.end(), time);
+    size_t key = static_cast<size_t>(it - track.times.begin());
+
+    if (it != track.times.end() && *it == time) {
+        track.values[key] = translation;
+    } else {
+        track.times.insert(it, time);
+        track.values.insert(track.values.begin() + key, translation);
+    }
+    addKeyframeTime(time);
+}
+
+void AnimationClip::addKeyframe(float time, const SkeletalModel& model) {
+    for (size_t i = 0; i < model.getJoints().size(); ++i) {
+        setRotationKey(static_cast<int>(i), time, model.getJointRotation(static_cast<int>(i)));
+    }
+}
+
+size_t AnimationClip::findKey(const std::vector<float>& times, float time, size_t key) {
+
+    // Going backwards (a loop or a seek) restarts the scan
+    if (key >= times.size() || times[key] > time) key = 0;
+    while (key + 1 < times.size() && times[key + 1] <= time) ++key;
+    return key;
+}
+
+void AnimationClip::sample(float time, Cursor& cursor, PoseBuffer& pose) const {
+    size_t jointCount = rotationTracks.size();
+    cursor.rotationKeys.resize(jointCount, 0);
+    cursor.translationKeys.resize(jointCount, 0);
+    if (pose.getJointCount() < jointCount) pose.resize(jointCount);
+
+    for (size_t j = 0; j < jointCount; ++j) {
+        const RotationTrack& rotationTrack = rotationTracks[j];
+        if (!rotationTrack.times.empty()) {
+            size_t key = findKey(rotationTrack.times, time, cursor.rotationKeys[j]);
+            cursor.rotationKeys[j] = key;
+
+            if (key + 1 < rotationTrack.times.size() && time > rotationTrack.times[key]) {
+                float t0 = rotationTrack.times[key];
+                float alpha = (time - t0) / (rotationTrack.times[key + 1] - t0);
+                pose.setRotation(j, glm::slerp(rotationTrack.values[key], rotationTrack.values[key + 1], alpha));
+            } else {
+                pose.setRotation(j, rotationTrack.values[key]);
+            }
+        }
+
+        const TranslationTrack& translationTrack = translationTracks[j];
+        if (!translationTrack.times.empty()) {
+            size_t key = findKey(translationTrack.times, time, cursor.translationKeys[j]);
+            cursor.translationKeys[j] = key;
+
+            if (key + 1 < translationTrack.times.size() && time > translationTrack.times[key]) {
+                float t0 = translationTrack.times[key];
+                float alpha = (time - t0) / (translationTrack.times[key + 1] - t0);
+                pose.setTranslation(j, glm::mix(translationTrack.values[key], translationTrack.values[key + 1], alpha));
+            } else {
+                pose.setTranslation(j, translationTrack.values[key]);
+            }
+        }
+    }
+}
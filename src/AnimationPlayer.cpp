@@ -0,0 +1,167 @@
+#include "AnimationPlayer.h"
+
+#include <algorithm>
+#include <cmath>
+
+const double AnimationPlayer::FIXED_TIMESTEP = 1.0 / 60.0;
+
+AnimationPlayer::AnimationPlayer()
+    : clip(nullptr), compressedClip(nullptr), stream(nullptr), time(0.0), accumulator(0.0), playing(false), looping(true), speed(1.0f), poseDirty(false) {}
+
+// Getter and setter for the clip
+const AnimationClip* AnimationPlayer::getClip() const { return clip; }
+
+void AnimationPlayer::setClip(const AnimationClip* clip) {
+    this->clip = clip;
+    cursor = AnimationClip::Cursor();
+    time = 0.0;
+    accumulator = 0.0;
+    poseDirty = true;
+}
+
+// Getter and setter for the compressed clip
+const CompressedClip* AnimationPlayer::getCompressedClip() const { return compressedClip; }
+
+void AnimationPlayer::setCompressedClip(const CompressedClip* compressedClip) {
+    this->compressedClip = compressedClip;
+    cursor = AnimationClip::Cursor();
+    poseDirty = true;
+}
+
+// Getter and setter for the stream
+AnimationStream* AnimationPlayer::getStream() const { return stream; }
+
+void AnimationPlayer::setStream(AnimationStream* stream) {
+    this->stream = stream;
+    time = std::min(time, static_cast<double>(getDuration()));
+    poseDirty = true;
+}
+
+bool AnimationPlayer::hasClip() const {
+    if (stream) return stream->isOpen() && stream->getFrameCount() > 0;
+    return compressedClip ? !compressedClip->isEmpty() : (clip && !clip->isEmpty());
+}
+
+float AnimationPlayer::getDuration() const {
+    if (stream) return stream->getDuration();
+    if (compressedClip) return compressedClip->getDuration();
+    return clip ? clip->getDuration() : 0.0f;
+}
+
+// Getters and setters for the playback state
+bool AnimationPlayer::isPlaying() const { return playing; }
+
+void AnimationPlayer::setPlaying(bool playing) {
+    // Restart a clip that ran to its end
+    if (playing && !this->playing && !looping && time >= getDuration()) time = 0.0;
+    this->playing = playing;
+    accumulator = 0.0;
+}
+
+bool AnimationPlayer::isLooping() const { return looping; }
+void AnimationPlayer::setLooping(bool looping) { this->looping = looping; }
+float AnimationPlayer::getSpeed() const { return speed; }
+void AnimationPlayer::setSpeed(float speed) { this->speed = std::max(0.0f, speed); }
+
+float AnimationPlayer::getTime() const { return static_cast<float>(time); }
+
+void AnimationPlayer::setTime(float time) {
+    this->time = glm::clamp(time, 0.0f, getDuration());
+    poseDirty = true;
+}
+
+void AnimationPlayer::step() {
+    time += FIXED_TIMESTEP;
+
+    double duration = getDuration();
+    if (time < duration) return;
+
+    if (looping && duration > 0.0) {
+        time = std::fmod(time, duration);
+    } else {
+        time = duration;
+        playing = false;
+    }
+}
+
+bool AnimationPlayer::update(double deltaTime, SkeletalModel& model) {
+    if (!advance(deltaTime)) return false;
+
+    return apply(model);
+}
+
+bool AnimationPlayer::advance(double deltaTime) {
+    if (!hasClip()) return false;
+
+    if (playing) {
+        accumulator += deltaTime * speed;
+
+        int steps = 0;
+        while (accumulator >= FIXED_TIMESTEP && steps < MAX_STEPS_PER_UPDATE && playing) {
+            step();
+            accumulator -= FIXED_TIMESTEP;
+            ++steps;
+        }
+
+        if (steps == MAX_STEPS_PER_UPDATE || !playing) accumulator = 0.0;
+        if (steps > 0) poseDirty = true;
+    }
+
+    return poseDirty;
+}
+
+bool AnimationPlayer::sample(PoseBuffer& out) {
+    poseDirty = false;
+    if (!hasClip()) return false;
+
+    if (stream) {
+        // Retry on the next update rather than wait for the disk
+        if (!stream->sample(static_cast<float>(time), out)) {
+            poseDirty = true;
+            return false;
+        }
+        return true;
+    }
+
+    if (compressedClip) {
+        compressedClip->sample(static_cast<float>(time), cursor, out);
+    } else {
+        clip->sample(static_cast<float>(time), cursor, out);
+    }
+    return true;
+}
+
+bool AnimationPlayer::hasRotationTrack(int jointIndex) const {
+    if (stream) return jointIndex < static_cast<int>(stream->getJointCount());
+    return compressedClip ? compressedClip->hasRotationTrack(jointIndex) : (clip && clip->hasRotationTrack(jointIndex));
+}
+
+bool AnimationPlayer::hasTranslationTrack(int jointIndex) const {
+    if (stream) return jointIndex < static_cast<int>(stream->getJointCount());
+    return compressedClip ? compressedClip->hasTranslationTrack(jointIndex) : (clip && clip->hasTranslationTrack(jointIndex));
+}
+
+size_t AnimationPlayer::getMemoryUsage() const {
+    return cursor.getMemoryUsage() + pose.getMemoryUsage();
+}
+
+bool AnimationPlayer::apply(SkeletalModel& model) {
+    if (!sample(pose)) return false;
+
+    if (stream) {
+        int jointCount = static_cast<int>(std::min(stream->getJointCount(), model.getJoints().size()));
+        for (int j = 0; j < jointCount; ++j) {
+            model.setJointRotation(j, pose.getRotation(j));
+            model.setJointTranslation(j, pose.getTranslation(j));
+        }
+        return true;
+    }
+
+    int jointCount = static_cast<int>(std::min(pose.getJointCount(), model.getJoints().size()));
+    for (int j = 0; j < jointCount; ++j) {
+        if (hasRotationTrack(j)) model.setJointRotation(j, pose.getRotation(j));
+        if (hasTranslationTrack(j)) model.setJointTranslation(j, pose.getTranslation(j));
+    }
+
+    return true;
+}
@@ -0,0 +1,211 @@
+#include "AnimationStream.h"
+#include "CompressedClip.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+static_assert(sizeof(AnimationStream::Header) == 32, "AnimationStream::Header must be 32 packed bytes");
+
+static const char ANIMATION_STREAM_MAGIC[4] = { 'H', 'M', 'A', 'S' };
+
+AnimationStream::AnimationStream() : stopping(false), requestedChunk(0), residentBegin(0), residentEnd(0) {
+    fillHeader(header, 0, 0, 1, 1.0f);
+}
+
+AnimationStream::~AnimationStream() {
+    close();
+}
+
+bool AnimationStream::open(const std::string& path) {
+    close();
+
+    // Scrubbing jumps around; the prefetch thread decides what to read ahead
+    if (!file.open(path, false)) return false;
+
+    if (file.getSize() < sizeof(Header)) {
+        close();
+        return false;
+    }
+    std::memcpy(&header, file.getData(), sizeof(Header));
+
+    uint64_t frameSize = getFrameSize(header.jointCount);
+    uint64_t dataSize = static_cast<uint64_t>(header.frameCount) * frameSize;
+    if (!isValidHeader(header) || header.chunkSize != header.framesPerChunk * frameSize ||
+        dataSize > file.getSize() - sizeof(Header)) {
+        close();
+        return false;
+    }
+
+    stopping = false;
+    requestedChunk = 0;
+    residentBegin = 0;
+    residentEnd = 0;
+    prefetchThread = std::thread(&AnimationStream::prefetchLoop, this);
+    return true;
+}
+
+void AnimationStream::close() {
+    if (prefetchThread.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wakeCondition.notify_one();
+        prefetchThread.join();
+    }
+
+    file.close();
+    fillHeader(header, 0, 0, 1, 1.0f);
+    residentBegin = 0;
+    residentEnd = 0;
+}
+
+bool AnimationStream::isOpen() const { return file.isOpen(); }
+size_t AnimationStream::getJointCount() const { return header.jointCount; }
+size_t AnimationStream::getFrameCount() const { return header.frameCount; }
+float AnimationStream::getSampleRate() const { return header.sampleRate; }
+size_t AnimationStream::getFileSize() const { return file.getSize(); }
+
+float AnimationStream::getDuration() const {
+    return header.frameCount > 1 ? (header.frameCount - 1) / header.sampleRate : 0.0f;
+}
+
+size_t AnimationStream::getResidentSize() const {
+    size_t begin = residentBegin, end = residentEnd;
+    return end > begin ? static_cast<size_t>((end - begin) * header.chunkSize) : 0;
+}
+
+bool AnimationStream::sample(float time, PoseBuffer& pose) {
+    if (!isOpen() || header.frameCount == 0) return false;
+
+    float position = glm::clamp(time * header.sampleRate, 0.0f, static_cast<float>(header.frameCount - 1));
+    size_t frame0 = static_cast<size_t>(position);
+    size_t frame1 = std::min<size_t>(frame0 + 1, header.frameCount - 1);
+    float alpha = position - frame0;
+
+    size_t chunk0 = frame0 / header.framesPerChunk;
+    size_t chunk1 = frame1 / header.framesPerChunk;
+    requestChunk(chunk0);
+    if (!isResident(chunk0) || !isResident(chunk1)) return false;
+
+    const unsigned char* data0 = getFrameData(frame0);
+    const unsigned char* data1 = getFrameData(frame1);
+    const unsigned char* translations0 = data0 + header.jointCount * ROTATION_BYTES;
+    const unsigned char* translations1 = data1 + header.jointCount * ROTATION_BYTES;
+
+    if (pose.getJointCount() < header.jointCount) pose.resize(header.jointCount);
+
+    for (size_t j = 0; j < header.jointCount; ++j) {
+        uint16_t encoded0[3], encoded1[3];
+        std::memcpy(encoded0, data0 + j * ROTATION_BYTES, ROTATION_BYTES);
+        std::memcpy(encoded1, data1 + j * ROTATION_BYTES, ROTATION_BYTES);
+
+        // Frames are close together, so nlerp in the shorter direction is enough
+        glm::quat q0 = CompressedClip::decodeRotation(encoded0);
+        glm::quat q1 = CompressedClip::decodeRotation(encoded1);
+        if (glm::dot(q0, q1) < 0.0f) q1 = -q1;
+        pose.setRotation(j, glm::normalize(q0 + (q1 - q0) * alpha));
+
+        glm::vec3 t0, t1;
+        std::memcpy(&t0, translations0 + j * TRANSLATION_BYTES, TRANSLATION_BYTES);
+        std::memcpy(&t1, translations1 + j * TRANSLATION_BYTES, TRANSLATION_BYTES);
+        pose.setTranslation(j, glm::mix(t0, t1, alpha));
+    }
+
+    return true;
+}
+
+size_t AnimationStream::getFrameSize(size_t jointCount) {
+    return jointCount * (ROTATION_BYTES + TRANSLATION_BYTES);
+}
+
+bool AnimationStream::isValidHeader(const Header& header) {
+    return std::memcmp(header.magic, ANIMATION_STREAM_MAGIC, sizeof(ANIMATION_STREAM_MAGIC)) == 0 &&
+           header.version == VERSION && header.jointCount > 0 && header.framesPerChunk > 0 &&
+           header.sampleRate > 0.0f;
+}
+
+void AnimationStream::fillHeader(Header& header, uint32_t jointCount, uint32_t frameCount,
+                                 uint32_t framesPerChunk, float sampleRate) {
+    std::memcpy(header.magic, ANIMATION_STREAM_MAGIC, sizeof(ANIMATION_STREAM_MAGIC));
+    header.version = VERSION;
+    header.jointCount = jointCount;
+    header.frameCount = frameCount;
+    header.framesPerChunk = framesPerChunk;
+    header.sampleRate = sampleRate;
+    header.chunkSize = static_cast<uint64_t>(framesPerChunk) * getFrameSize(jointCount);
+}
+
+size_t AnimationStream::getChunkCount() const {
+    return (header.frameCount + header.framesPerChunk - 1) / header.framesPerChunk;
+}
+
+uint64_t AnimationStream::getChunkOffset(size_t chunk) const {
+    return sizeof(Header) + chunk * header.chunkSize;
+}
+
+const unsigned char* AnimationStream::getFrameData(size_t frame) const {
+    return file.getData() + sizeof(Header) + frame * getFrameSize(header.jointCount);
+}
+
+bool AnimationStream::isResident(size_t chunk) const {
+    return chunk >= residentBegin && chunk < residentEnd;
+}
+
+void AnimationStream::requestChunk(size_t chunk) {
+    if (requestedChunk.exchange(chunk) == chunk) return;
+
+    // Lock so the wake-up cannot slip between the thread's check and its wait
+    { std::lock_guard<std::mutex> lock(mutex); }
+    wakeCondition.notify_one();
+}
+
+void AnimationStream::prefetchLoop() {
+    size_t chunkCount = getChunkCount();
+    size_t begin = 0, end = 0; // Chunks this thread has paged in
+    size_t handled = chunkCount; // No request handled yet
+
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        wakeCondition.wait(lock, [&] { return stopping || requestedChunk != handled; });
+        if (stopping) break;
+        lock.unlock();
+
+        // One read: a request stored between two reads would be marked
+        // handled without its window ever being loaded
+        handled = requestedChunk.load();
+        size_t chunk = std::min(handled, chunkCount - 1);
+        size_t windowBegin = chunk > CHUNKS_BEHIND ? chunk - CHUNKS_BEHIND : 0;
+        size_t windowEnd = std::min(chunkCount, chunk + 1 + CHUNKS_AHEAD);
+
+        // Keep what is still in the window; after a jump start over at the playhead
+        size_t keepBegin = std::max(begin, windowBegin);
+        size_t keepEnd = std::min(end, windowEnd);
+        if (keepBegin >= keepEnd || chunk < keepBegin || chunk > keepEnd) keepBegin = keepEnd = chunk;
+
+        // Stop sample() reading a chunk before it is released
+        residentBegin = keepBegin;
+        residentEnd = keepEnd;
+        if (begin < keepBegin) file.release(getChunkOffset(begin), getChunkOffset(std::min(end, keepBegin)) - getChunkOffset(begin));
+        if (end > keepEnd) {
+            size_t from = std::max(begin, keepEnd);
+            file.release(getChunkOffset(from), getChunkOffset(end) - getChunkOffset(from));
+        }
+        begin = keepBegin;
+        end = keepEnd;
+
+        // Page in from the playhead forwards, then behind it, publishing each
+        // chunk as it lands; give up early if the playhead jumps again
+        while (end < windowEnd && requestedChunk == handled) {
+            file.load(getChunkOffset(end), header.chunkSize);
+            residentEnd = ++end;
+        }
+        while (begin > windowBegin && requestedChunk == handled) {
+            file.load(getChunkOffset(begin - 1), header.chunkSize);
+            residentBegin = --begin;
+        }
+
+        lock.lock();
+    }
+}
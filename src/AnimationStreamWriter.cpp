@@ -0,0 +1,78 @@
+#include "AnimationStreamWriter.h"
+#include "CompressedClip.h"
+
+#include <algorithm>
+#include <cstring>
+
+AnimationStreamWriter::AnimationStreamWriter()
+    : jointCount(0), frameCount(0), framesPerChunk(1), sampleRate(1.0f) {}
+
+AnimationStreamWriter::~AnimationStreamWriter() {
+    close();
+}
+
+bool AnimationStreamWriter::open(const std::string& path, size_t jointCount, float sampleRate) {
+    close();
+
+    if (jointCount == 0 || sampleRate <= 0.0f) return false;
+
+    file.open(path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) return false;
+
+    size_t frameSize = AnimationStream::getFrameSize(jointCount);
+    this->jointCount = static_cast<uint32_t>(jointCount);
+    this->sampleRate = sampleRate;
+    frameCount = 0;
+    framesPerChunk = static_cast<uint32_t>(std::max<size_t>(1, AnimationStream::TARGET_CHUNK_SIZE / frameSize));
+    buffer.resize(frameSize);
+
+    // Placeholder until close() knows the frame count
+    AnimationStream::Header header;
+    AnimationStream::fillHeader(header, this->jointCount, 0, framesPerChunk, sampleRate);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    return file.good();
+}
+
+bool AnimationStreamWriter::writeFrame(const PoseBuffer& pose) {
+    if (!isOpen() || pose.getJointCount() < jointCount) return false;
+
+    unsigned char* rotations = buffer.data();
+    unsigned char* translations = rotations + jointCount * AnimationStream::ROTATION_BYTES;
+
+    for (size_t j = 0; j < jointCount; ++j) {
+        uint16_t encoded[3];
+        CompressedClip::encodeRotation(glm::normalize(pose.getRotation(j)), encoded);
+        std::memcpy(rotations + j * AnimationStream::ROTATION_BYTES, encoded, AnimationStream::ROTATION_BYTES);
+
+        glm::vec3 translation = pose.getTranslation(j);
+        std::memcpy(translations + j * AnimationStream::TRANSLATION_BYTES, &translation, AnimationStream::TRANSLATION_BYTES);
+    }
+
+    file.write(reinterpret_cast<const char*>(buffer.data()), static_cast<std::streamsize>(buffer.size()));
+    ++frameCount;
+
+    return file.good();
+}
+
+bool AnimationStreamWriter::close() {
+    if (!isOpen()) return false;
+
+    AnimationStream::Header header;
+    AnimationStream::fillHeader(header, jointCount, frameCount, framesPerChunk, sampleRate);
+    file.seekp(0);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    bool ok = file.good();
+    file.close();
+
+    buffer.clear();
+    return ok;
+}
+
+bool AnimationStreamWriter::isOpen() const { return file.is_open(); }
+size_t AnimationStreamWriter::getFrameCount() const { return frameCount; }
+
+uint64_t AnimationStreamWriter::getBytesWritten() const {
+    return sizeof(AnimationStream::Header) + static_cast<uint64_t>(frameCount) * AnimationStream::getFrameSize(jointCount);
+}
@@ -181,6 +181,17 @@ void Application::initOpenGL() {
 
     // Pass projection matrix to the shader
     renderer.setShaderProgram(shaderProgram);
+
+    // Skinning variant for ImportCharacter; characters fall back to CPU skinning without it
+    GLuint skinningShaderProgram = ShaderLoader::loadShaderFromFile("shaders/skinning_vertex_shader.glsl", "shaders/fragment_shader.glsl");
+    GLint skinningLinked = GL_FALSE;
+    if (skinningShaderProgram != 0) glGetProgramiv(skinningShaderProgram, GL_LINK_STATUS, &skinningLinked);
+    if (skinningLinked != GL_TRUE) {
+        std::cerr << "GPU skinning shader unavailable, using CPU skinning." << std::endl;
+        if (skinningShaderProgram != 0) glDeleteProgram(skinningShaderProgram);
+        skinningShaderProgram = 0;
+    }
+    renderer.setSkinningShaderProgram(skinningShaderProgram);
         
     GLint projLoc = glGetUniformLocation(shaderProgram, "projection");
     glUseProgram(shaderProgram);
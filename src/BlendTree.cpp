@@ -0,0 +1,116 @@
+#include "BlendTree.h"
+
+#include <iostream>
+
+BlendTree::BlendTree(size_t jointCount) : jointCount(jointCount) {}
+
+void BlendTree::clear() {
+    nodes.clear();
+    poses.clear();
+    masks.clear();
+}
+
+// Getter and setter for the joint count of every node's pose
+size_t BlendTree::getJointCount() const { return jointCount; }
+
+void BlendTree::setJointCount(size_t jointCount) {
+    this->jointCount = jointCount;
+    for (PoseBuffer& pose : poses) pose.resize(jointCount);
+    for (std::vector<float>& mask : masks) mask.resize(jointCount, 0.0f);
+}
+
+int BlendTree::addNode(NodeType type, int inputA, int inputB, int mask, float weight) {
+    int index = static_cast<int>(nodes.size());
+
+    bool validInputs = (type == INPUT) ||
+        (inputA >= 0 && inputA < index && inputB >= 0 && inputB < index);
+    bool validMask = mask < static_cast<int>(masks.size()) && (type != MASKED_BLEND || mask >= 0);
+
+    if (!validInputs || !validMask) {
+        std::cerr << "Error: Blend tree node inputs must be earlier nodes." << std::endl;
+        return -1;
+    }
+
+    Node node = { type, inputA, inputB, mask, weight };
+    nodes.push_back(node);
+    poses.push_back(PoseBuffer(jointCount));
+    return index;
+}
+
+int BlendTree::addInput() {
+    return addNode(INPUT, -1, -1, -1, 0.0f);
+}
+
+int BlendTree::addBlend(int a, int b, float weight) {
+    return addNode(BLEND, a, b, -1, weight);
+}
+
+int BlendTree::addMaskedBlend(int a, int b, int mask, float weight) {
+    return addNode(MASKED_BLEND, a, b, mask, weight);
+}
+
+int BlendTree::addAdditive(int base, int additive, float weight, int mask) {
+    return addNode(ADDITIVE, base, additive, mask, weight);
+}
+
+int BlendTree::addMask(const std::vector<float>& jointWeights) {
+    masks.push_back(jointWeights);
+    masks.back().resize(jointCount, 0.0f);
+    return static_cast<int>(masks.size()) - 1;
+}
+
+std::vector<float> BlendTree::makeSubtreeMask(const SkeletalModel& model, int rootJoint) {
+    const std::vector<int>& parents = model.getParentIndices();
+    std::vector<float> mask(parents.size(), 0.0f);
+
+    for (size_t i = 0; i < parents.size(); ++i) {
+        for (int j = static_cast<int>(i); j >= 0; j = parents[j]) {
+            if (j == rootJoint) {
+                mask[i] = 1.0f;
+                break;
+            }
+        }
+    }
+    return mask;
+}
+
+// Getters and setters for nodes
+size_t BlendTree::getNodeCount() const { return nodes.size(); }
+BlendTree::NodeType BlendTree::getNodeType(int node) const { return nodes[node].type; }
+float BlendTree::getWeight(int node) const { return nodes[node].weight; }
+void BlendTree::setWeight(int node, float weight) { nodes[node].weight = weight; }
+PoseBuffer& BlendTree::getPose(int node) { return poses[node]; }
+
+const PoseBuffer& BlendTree::evaluate() {
+    static const PoseBuffer emptyPose;
+    if (nodes.empty()) return emptyPose;
+
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        const Node& node = nodes[i];
+
+        switch (node.type) {
+        case INPUT:
+            break;
+        case BLEND:
+            PoseBuffer::blend(poses[node.inputA], poses[node.inputB], node.weight, poses[i]);
+            break;
+        case MASKED_BLEND:
+            PoseBuffer::maskedBlend(poses[node.inputA], poses[node.inputB], masks[node.mask], node.weight, poses[i]);
+            break;
+        case ADDITIVE:
+            PoseBuffer::addLayer(poses[node.inputA], poses[node.inputB], node.weight,
+                                 node.mask >= 0 ? &masks[node.mask] : nullptr, poses[i]);
+            break;
+        }
+    }
+
+    return poses.back();
+}
+
+size_t BlendTree::getMemoryUsage() const {
+    size_t bytes = nodes.capacity() * sizeof(Node) + poses.capacity() * sizeof(PoseBuffer) +
+                   masks.capacity() * sizeof(std::vector<float>);
+    for (const PoseBuffer& pose : poses) bytes += pose.getMemoryUsage();
+    for (const std::vector<float>& mask : masks) bytes += mask.capacity() * sizeof(float);
+    return bytes;
+}
@@ -0,0 +1,302 @@
+#include "BvhImporter.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+
+static inline bool isWhitespace(char c) {
+    return c == ' ' || c == '\n' || c == '\t' || c == '\r';
+}
+
+BvhImporter::BvhImporter()
+    : cursor(nullptr), end(nullptr), line(1), fitSize(0.0f), scale(1.0f), frameCount(0), frameTime(0.0f), channelCount(0) {}
+
+// Setter for the fit size
+void BvhImporter::setFitSize(float fitSize) { this->fitSize = std::max(0.0f, fitSize); }
+
+// Getters for what the last load() read
+size_t BvhImporter::getFrameCount() const { return frameCount; }
+float BvhImporter::getFrameTime() const { return frameTime; }
+size_t BvhImporter::getChannelCount() const { return channelCount; }
+float BvhImporter::getScale() const { return scale; }
+
+bool BvhImporter::load(const std::string& path, SkeletalModel& model, AnimationClip& clip) {
+    offsets.clear();
+    parents.clear();
+    channels.clear();
+    clip.clear();
+    frameCount = 0;
+    frameTime = 0.0f;
+    channelCount = 0;
+    scale = 1.0f;
+    line = 1;
+
+    if (!file.open(path)) {
+        std::cerr << "Unable to open .bvh file: " << path << std::endl;
+        return false;
+    }
+    cursor = reinterpret_cast<const char*>(file.getData());
+    end = cursor + file.getSize();
+
+    bool ok = expect("HIERARCHY");
+    while (ok && expect("ROOT")) ok = parseJoint(-1);
+    if (ok && offsets.empty()) ok = fail("expected ROOT");
+
+    // expect("ROOT") stopped at the next keyword, which must be MOTION
+    const char* token;
+    size_t length;
+    if (ok && !(nextToken(token, length) && length == 6 && std::memcmp(token, "MOTION", 6) == 0)) {
+        ok = fail("expected MOTION");
+    }
+
+    if (!ok) {
+        file.close();
+        return false;
+    }
+
+    // Fit the rest pose: farthest joint from the root, all offsets summed
+    if (fitSize > 0.0f) {
+        std::vector<glm::vec3> restPositions(offsets.size());
+        float reach = 0.0f;
+        for (size_t i = 0; i < offsets.size(); ++i) {
+            restPositions[i] = parents[i] >= 0 ? restPositions[parents[i]] + offsets[i] : glm::vec3(0.0f);
+            reach = std::max(reach, glm::length(restPositions[i]));
+        }
+        if (reach > 0.0f) scale = fitSize / reach;
+    }
+
+    std::vector<Joint*> joints(offsets.size());
+    for (size_t i = 0; i < offsets.size(); ++i) {
+        joints[i] = new Joint;
+        joints[i]->setTransform(glm::translate(glm::mat4(1.0f), offsets[i] * scale));
+        if (parents[i] >= 0) joints[parents[i]]->addChild(joints[i]);
+    }
+    model.setRootJoint(joints.front());
+    model.setJoints(joints);
+
+    ok = parseMotion(clip);
+    file.close();
+    return ok;
+}
+
+bool BvhImporter::parseJoint(int parent) {
+    int joint = static_cast<int>(offsets.size());
+    offsets.push_back(glm::vec3(0.0f));
+    parents.push_back(parent);
+
+    skipLine(); // Joint name, which may contain spaces
+    if (!expect("{") || !expect("OFFSET")) return fail("expected { OFFSET");
+    for (int c = 0; c < 3; ++c) {
+        if (!readNumber(offsets[joint][c])) return fail("expected an OFFSET value");
+    }
+
+    const char* token;
+    size_t length;
+    while (nextToken(token, length)) {
+        if (length == 8 && std::memcmp(token, "CHANNELS", 8) == 0) {
+            if (!parseChannels(joint)) return false;
+        } else if (length == 5 && std::memcmp(token, "JOINT", 5) == 0) {
+            if (!parseJoint(joint)) return false;
+        } else if (length == 3 && std::memcmp(token, "End", 3) == 0) {
+            // End Site: a leaf joint at the tip of the chain
+            offsets.push_back(glm::vec3(0.0f));
+            parents.push_back(joint);
+            if (!expect("Site") || !expect("{") || !expect("OFFSET")) return fail("expected Site { OFFSET");
+            for (int c = 0; c < 3; ++c) {
+                if (!readNumber(offsets.back()[c])) return fail("expected an OFFSET value");
+            }
+            if (!expect("}")) return fail("expected } after End Site");
+        } else if (length == 1 && token[0] == '}') {
+            return true;
+        } else {
+            return fail("unexpected token in joint");
+        }
+    }
+
+    return fail("unexpected end of file in HIERARCHY");
+}
+
+bool BvhImporter::parseChannels(int joint) {
+    float count;
+    if (!readNumber(count) || count < 0.0f || count > MAX_CHANNELS_PER_JOINT) return fail("bad CHANNELS count");
+
+    JointChannels jointChannels = {};
+    jointChannels.joint = joint;
+    jointChannels.count = static_cast<int>(count);
+
+    static const char* names[] = { "Xposition", "Yposition", "Zposition", "Xrotation", "Yrotation", "Zrotation" };
+    for (int c = 0; c < jointChannels.count; ++c) {
+        const char* token;
+        size_t length;
+        if (!nextToken(token, length)) return fail("expected a channel name");
+
+        int type = 0;
+        while (type < 6 && !(length == 9 && std::memcmp(token, names[type], 9) == 0)) ++type;
+        if (type == 6) return fail("unknown channel");
+
+        jointChannels.types[c] = static_cast<ChannelType>(type);
+        if (type <= Z_POSITION) jointChannels.hasPosition = true;
+        else jointChannels.hasRotation = true;
+    }
+
+    channels.push_back(jointChannels);
+    channelCount += jointChannels.count;
+    return true;
+}
+
+bool BvhImporter::parseMotion(AnimationClip& clip) {
+    float frames;
+    if (!expect("Frames:") || !readNumber(frames) || frames < 0.0f) return fail("expected Frames:");
+    if (!expect("Frame") || !expect("Time:") || !readNumber(frameTime) || frameTime <= 0.0f) return fail("expected Frame Time:");
+
+    size_t expectedFrames = static_cast<size_t>(frames);
+    std::vector<float> values(channelCount); // One frame
+
+    static const glm::vec3 axes[3] = { glm::vec3(1, 0, 0), glm::vec3(0, 1, 0), glm::vec3(0, 0, 1) };
+
+    for (frameCount = 0; frameCount < expectedFrames; ++frameCount) {
+        for (size_t c = 0; c < channelCount; ++c) {
+            if (!readNumber(values[c])) {
+                // A truncated take keeps the frames read so far
+                if (cursor < end) return fail("expected a channel value");
+                std::cerr << "Warning: .bvh file ends after " << frameCount << " of " << expectedFrames << " frames" << std::endl;
+                return frameCount > 0;
+            }
+        }
+
+        float time = frameCount * frameTime;
+        const float* value = values.data();
+
+        for (const JointChannels& joint : channels) {
+            glm::vec3 position = offsets[joint.joint];
+            glm::quat rotation(1.0f, 0.0f, 0.0f, 0.0f);
+
+            // Rotations compose in channel order, each about the axis in the rotated frame
+            for (int c = 0; c < joint.count; ++c, ++value) {
+                ChannelType type = joint.types[c];
+                if (type <= Z_POSITION) {
+                    position[type] = *value;
+                } else {
+                    rotation = rotation * glm::angleAxis(glm::radians(*value), axes[type - X_ROTATION]);
+                }
+            }
+
+            if (joint.hasRotation) clip.setRotationKey(joint.joint, time, rotation);
+            if (joint.hasPosition) clip.setTranslationKey(joint.joint, time, position * scale);
+        }
+    }
+
+    return true;
+}
+
+bool BvhImporter::nextToken(const char*& token, size_t& length) {
+    while (cursor < end && isWhitespace(*cursor)) {
+        if (*cursor == '\n') ++line;
+        ++cursor;
+    }
+    if (cursor == end) return false;
+
+    token = cursor;
+    while (cursor < end && !isWhitespace(*cursor)) ++cursor;
+    length = static_cast<size_t>(cursor - token);
+    return true;
+}
+
+// Consume the next token if it is keyword; otherwise leave the cursor where it was
+bool BvhImporter::expect(const char* keyword) {
+    const char* saved = cursor;
+    int savedLine = line;
+
+    const char* token;
+    size_t length;
+    if (nextToken(token, length) && length == std::strlen(keyword) && std::memcmp(token, keyword, length) == 0) return true;
+
+    cursor = saved;
+    line = savedLine;
+    return false;
+}
+
+bool BvhImporter::readNumber(float& value) {
+    while (cursor < end && isWhitespace(*cursor)) {
+        if (*cursor == '\n') ++line;
+        ++cursor;
+    }
+
+    const char* next = parseFloat(cursor, end, value);
+    if (!next) return false;
+    cursor = next;
+    return true;
+}
+
+void BvhImporter::skipLine() {
+    while (cursor < end && *cursor != '\n') ++cursor;
+}
+
+bool BvhImporter::fail(const char* message) const {
+    std::cerr << "Error: .bvh line " << line << ": " << message << std::endl;
+    return false;
+}
+
+const char* BvhImporter::parseFloat(const char* in, const char* end, float& value) {
+    static const double powersOfTen[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+                                          1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+    const char* p = in;
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+')) negative = (*p++ == '-');
+
+    // Up to 19 significant digits fit in the mantissa; later ones only shift the exponent
+    uint64_t mantissa = 0;
+    int exponent = 0;
+    int digits = 0;
+    bool anyDigits = false;
+
+    for (; p < end && *p >= '0' && *p <= '9'; ++p, anyDigits = true) {
+        if (digits < 19) {
+            mantissa = mantissa * 10 + static_cast<uint64_t>(*p - '0');
+            if (mantissa) ++digits;
+        } else {
+            ++exponent;
+        }
+    }
+    if (p < end && *p == '.') {
+        for (++p; p < end && *p >= '0' && *p <= '9'; ++p, anyDigits = true) {
+            if (digits < 19) {
+                mantissa = mantissa * 10 + static_cast<uint64_t>(*p - '0');
+                if (mantissa) ++digits;
+                --exponent;
+            }
+        }
+    }
+    if (!anyDigits) return nullptr;
+
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        const char* q = p + 1;
+        bool negativeExponent = false;
+        if (q < end && (*q == '-' || *q == '+')) negativeExponent = (*q++ == '-');
+
+        if (q < end && *q >= '0' && *q <= '9') {
+            int e = 0;
+            for (; q < end && *q >= '0' && *q <= '9'; ++q) {
+                if (e < 10000) e = e * 10 + (*q - '0');
+            }
+            exponent += negativeExponent ? -e : e;
+            p = q;
+        }
+    }
+
+    double result = static_cast<double>(mantissa);
+    if (exponent < 0) {
+        result = -exponent <= 22 ? result / powersOfTen[-exponent] : result * std::pow(10.0, exponent);
+    } else if (exponent > 0) {
+        result = exponent <= 22 ? result * powersOfTen[exponent] : result * std::pow(10.0, exponent);
+    }
+
+    value = static_cast<float>(negative ? -result : result);
+    return p;
+}
@@ -0,0 +1,205 @@
+#include "CharacterAsset.h"
+
+#include <algorithm>
+#include <cstddef>
+
+CharacterAsset::CharacterAsset()
+    : boundsCenter(0.0f), boundsRadius(0.0f), skinnedVAO(0), skinnedVBO(0), skinnedEBO(0) {}
+
+CharacterAsset::CharacterAsset(const std::vector<glm::vec3>& bindVertices, const std::vector<std::vector<int>>& faces,
+                               const std::vector<glm::mat4>& jointTransforms, const std::vector<int>& parentIndices,
+                               const SkinWeights& attachments, const PackedSkinWeights& packedAttachments)
+    : bindVertices(bindVertices), faces(faces), jointTransforms(jointTransforms), parentIndices(parentIndices),
+      attachments(attachments), packedAttachments(packedAttachments), boundsCenter(0.0f), boundsRadius(0.0f),
+      skinnedVAO(0), skinnedVBO(0), skinnedEBO(0) {
+
+    computeBindNormals();
+    computeLODData();
+    skinningKernel.setup(this->bindVertices, bindNormals, this->attachments);
+}
+
+// Never builds GL objects (no faces), so it can outlive the context
+const std::shared_ptr<const CharacterAsset>& CharacterAsset::getEmpty() {
+    static const std::shared_ptr<const CharacterAsset> empty = std::make_shared<CharacterAsset>();
+    return empty;
+}
+
+CharacterAsset::~CharacterAsset() {
+    if (skinnedVAO) glDeleteVertexArrays(1, &skinnedVAO);
+    if (skinnedVBO) glDeleteBuffers(1, &skinnedVBO);
+    if (skinnedEBO) glDeleteBuffers(1, &skinnedEBO);
+}
+
+void CharacterAsset::createSkeleton(SkeletalModel& model) const {
+    if (jointTransforms.empty()) return;
+
+    std::vector<Joint*> joints(jointTransforms.size());
+    for (size_t i = 0; i < joints.size(); ++i) {
+        joints[i] = new Joint;
+        joints[i]->setTransform(jointTransforms[i]);
+        if (parentIndices[i] >= 0) joints[parentIndices[i]]->addChild(joints[i]);
+    }
+
+    model.setRootJoint(joints.front());
+    model.setJoints(joints);
+    model.computeBindWorldToJointTransforms();
+}
+
+size_t CharacterAsset::getJointCount() const { return jointTransforms.size(); }
+
+// Getters for the bind mesh
+const std::vector<glm::vec3>& CharacterAsset::getBindVertices() const { return bindVertices; }
+const std::vector<glm::vec3>& CharacterAsset::getBindNormals() const { return bindNormals; }
+const std::vector<std::vector<int>>& CharacterAsset::getFaces() const { return faces; }
+
+// Getters for the weights and the SIMD kernel
+const SkinWeights& CharacterAsset::getAttachments() const { return attachments; }
+const PackedSkinWeights& CharacterAsset::getPackedAttachments() const { return packedAttachments; }
+const SkinningKernel& CharacterAsset::getSkinningKernel() const { return skinningKernel; }
+
+// Getters for the LOD data
+const std::vector<int>& CharacterAsset::getDominantJoints() const { return dominantJoints; }
+glm::vec3 CharacterAsset::getBoundsCenter() const { return boundsCenter; }
+float CharacterAsset::getBoundsRadius() const { return boundsRadius; }
+
+GLuint CharacterAsset::getSkinnedVAO() const {
+    if (!skinnedVAO && !faces.empty()) setupSkinnedMeshBuffer();
+    return skinnedVAO;
+}
+
+size_t CharacterAsset::getMemoryUsage() const {
+    size_t faceBytes = faces.capacity() * sizeof(std::vector<int>);
+    for (const std::vector<int>& face : faces) faceBytes += face.capacity() * sizeof(int);
+
+    return (bindVertices.capacity() + bindNormals.capacity()) * sizeof(glm::vec3) + faceBytes +
+           jointTransforms.capacity() * sizeof(glm::mat4) + parentIndices.capacity() * sizeof(int) +
+           attachments.getMemoryUsage() + packedAttachments.getMemoryUsage() + skinningKernel.getMemoryUsage() +
+           dominantJoints.capacity() * sizeof(int);
+}
+
+void CharacterAsset::computeBindNormals() {
+
+    // The unnormalized cross product is twice the face area, so summing it
+    // weights each face by its area
+    bindNormals.assign(bindVertices.size(), glm::vec3(0.0f));
+
+    for (const auto& face : faces) {
+        const glm::vec3& v0 = bindVertices[face[0]];
+        glm::vec3 areaNormal = glm::cross(bindVertices[face[1]] - v0, bindVertices[face[2]] - v0);
+
+        for (int j = 0; j < 3; ++j) {
+            bindNormals[face[j]] += areaNormal;
+        }
+    }
+
+    for (glm::vec3& normal : bindNormals) {
+        float length = glm::length(normal);
+        if (length > 0.0f) normal /= length;
+    }
+}
+
+void CharacterAsset::computeLODData() {
+    const std::vector<unsigned int>& offsets = attachments.getOffsets();
+    const std::vector<SkinWeights::Influence>& influences = attachments.getInfluences();
+
+    dominantJoints.assign(bindVertices.size(), -1);
+    for (size_t i = 0; i < bindVertices.size() && i < attachments.getVertexCount(); ++i) {
+        float heaviest = 0.0f;
+        for (unsigned int k = offsets[i]; k < offsets[i + 1]; ++k) {
+            if (influences[k].weight > heaviest) {
+                heaviest = influences[k].weight;
+                dominantJoints[i] = influences[k].jointIndex;
+            }
+        }
+    }
+
+    // Sphere around the bind pose bounding box
+    glm::vec3 minimum(0.0f), maximum(0.0f);
+    if (!bindVertices.empty()) minimum = maximum = bindVertices[0];
+    for (const glm::vec3& v : bindVertices) {
+        minimum = glm::min(minimum, v);
+        maximum = glm::max(maximum, v);
+    }
+
+    boundsCenter = 0.5f * (minimum + maximum);
+    boundsRadius = 0.0f;
+    for (const glm::vec3& v : bindVertices) {
+        boundsRadius = std::max(boundsRadius, glm::length(v - boundsCenter));
+    }
+}
+
+void CharacterAsset::setupSkinnedMeshBuffer() const {
+
+    // Bind pose positions and normals with the 4 heaviest influences per
+    // vertex, weights as 16-bit unorm. Built once for every character using
+    // the asset; only the palettes change from frame to frame.
+    struct SkinnedVertex {
+        float position[3];
+        float normal[3];
+        GLubyte joints[GPU_MAX_INFLUENCES];
+        GLushort weights[GPU_MAX_INFLUENCES];
+    };
+
+    std::vector<SkinnedVertex> skinnedVertices;
+    std::vector<unsigned int> skinnedIndices;
+    skinnedVertices.reserve(faces.size() * 3);
+    skinnedIndices.reserve(faces.size() * 3);
+
+    SkinWeights::Influence largest[GPU_MAX_INFLUENCES];
+    float weights[GPU_MAX_INFLUENCES];
+    unsigned int quantized[GPU_MAX_INFLUENCES];
+
+    for (size_t i = 0; i < faces.size(); ++i) {
+        for (int j = 0; j < 3; ++j) {
+            int vertexIndex = faces[i][j];
+            const glm::vec3& position = bindVertices[vertexIndex];
+            const glm::vec3& normal = bindNormals[vertexIndex]; // Skinned in the vertex shader
+
+            SkinnedVertex v = {};
+            v.position[0] = position.x; v.position[1] = position.y; v.position[2] = position.z;
+            v.normal[0] = normal.x; v.normal[1] = normal.y; v.normal[2] = normal.z;
+
+            // Unused slots keep joint 0 with weight 0
+            int count = attachments.getLargestInfluences(vertexIndex, GPU_MAX_INFLUENCES, largest);
+            for (int k = 0; k < count; ++k) weights[k] = largest[k].weight;
+            PackedSkinWeights::quantizeWeights(weights, count, 65535u, quantized);
+
+            for (int k = 0; k < count; ++k) {
+                v.joints[k] = static_cast<GLubyte>(largest[k].jointIndex);
+                v.weights[k] = static_cast<GLushort>(quantized[k]);
+            }
+
+            skinnedVertices.push_back(v);
+            skinnedIndices.push_back(static_cast<unsigned int>(skinnedIndices.size()));
+        }
+    }
+
+    glGenVertexArrays(1, &skinnedVAO);
+    glGenBuffers(1, &skinnedVBO);
+    glGenBuffers(1, &skinnedEBO);
+
+    glBindVertexArray(skinnedVAO);
+
+    glBindBuffer(GL_ARRAY_BUFFER, skinnedVBO);
+    glBufferData(GL_ARRAY_BUFFER, skinnedVertices.size() * sizeof(SkinnedVertex), skinnedVertices.data(), GL_STATIC_DRAW);
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, skinnedEBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, skinnedIndices.size() * sizeof(unsigned int), skinnedIndices.data(), GL_STATIC_DRAW);
+
+    GLsizei stride = sizeof(SkinnedVertex);
+
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(SkinnedVertex, position)); // Position
+    glEnableVertexAttribArray(0);
+
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(SkinnedVertex, normal)); // Normal
+    glEnableVertexAttribArray(1);
+
+    // Joint indices stay integers in the shader
+    glVertexAttribIPointer(3, GPU_MAX_INFLUENCES, GL_UNSIGNED_BYTE, stride, (void*)offsetof(SkinnedVertex, joints));
+    glEnableVertexAttribArray(3);
+
+    glVertexAttribPointer(4, GPU_MAX_INFLUENCES, GL_UNSIGNED_SHORT, GL_TRUE, stride, (void*)offsetof(SkinnedVertex, weights)); // Weights, normalized to [0, 1]
+    glEnableVertexAttribArray(4);
+
+    glBindVertexArray(0);
+}
@@ -0,0 +1,488 @@
+#include "CompressedClip.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+constexpr float CompressedClip::DEFAULT_TOLERANCE;
+
+static const float UINT16_UNITS = 65535.0f;            // Translations, and key times within a page
+static const uint32_t PAGE_UNITS = 65536;              // Time units per page
+static const double MAX_TIME_UNITS = 4294967295.0;
+static const float ROTATION_UNITS = 32767.0f;          // 15 bits per component
+static const float SMALLEST_THREE_RANGE = 0.70710678f; // |component| <= 1/sqrt(2) unless it is the largest
+
+// Original clip curves, sampled the way AnimationClip::sample() does
+template <typename T, typename Interpolate>
+static T sampleTrack(const std::vector<float>& times, const std::vector<T>& values, float time, Interpolate interpolate) {
+    size_t key = static_cast<size_t>(std::upper_bound(times.begin(), times.end(), time) - times.begin());
+    if (key == 0) return values.front();
+    if (key == times.size()) return values.back();
+
+    float t0 = times[key - 1];
+    return interpolate(values[key - 1], values[key], (time - t0) / (times[key] - t0));
+}
+
+static glm::quat nlerpRotation(const glm::quat& a, const glm::quat& b, float alpha) {
+    glm::quat target = glm::dot(a, b) < 0.0f ? -b : b;
+    return glm::normalize(a * (1.0f - alpha) + target * alpha);
+}
+
+// acos of the dot product has no float resolution left for tiny angles
+static float rotationAngle(const glm::quat& a, const glm::quat& b) {
+    glm::quat difference = glm::conjugate(a) * b;
+    return 2.0f * std::atan2(glm::length(glm::vec3(difference.x, difference.y, difference.z)), std::fabs(difference.w));
+}
+
+// Greedily extend each segment while interpolating its end keys stays within
+// tolerance of the original curve at every original key and halfway between.
+// keys holds the quantized values at quantized times.
+template <typename T, typename Original, typename Interpolate, typename Error>
+static std::vector<size_t> reduceKeys(const std::vector<float>& sourceTimes, const std::vector<float>& times,
+                                      const std::vector<T>& keys, float tolerance,
+                                      Original original, Interpolate interpolate, Error error) {
+    size_t count = keys.size();
+
+    auto segmentFits = [&](size_t start, size_t end) {
+        float span = times[end] - times[start];
+        for (size_t k = start; k <= end; ++k) {
+            float probes[2] = { sourceTimes[k], k < end ? 0.5f * (sourceTimes[k] + sourceTimes[k + 1]) : sourceTimes[k] };
+            for (float time : probes) {
+                float alpha = span > 0.0f ? glm::clamp((time - times[start]) / span, 0.0f, 1.0f) : 0.0f;
+                if (error(interpolate(keys[start], keys[end], alpha), original(time)) > tolerance) return false;
+            }
+        }
+        return true;
+    };
+
+    // A track that never leaves its first key needs only that key
+    bool constant = true;
+    for (size_t k = 0; k < count && constant; ++k) constant = error(keys[0], original(sourceTimes[k])) <= tolerance;
+    if (constant) return std::vector<size_t>(1, 0);
+
+    std::vector<size_t> kept(1, 0);
+    size_t start = 0;
+    while (start + 1 < count) {
+        size_t end = start + 1;
+        while (end + 1 < count && segmentFits(start, end + 1)) ++end;
+        kept.push_back(end);
+        start = end;
+    }
+    return kept;
+}
+
+// Page of a key: the last one starting at or before it. Pages ahead of
+// the track's first key, or past its last, hold no keys.
+static size_t findPage(const uint32_t* pages, size_t pageCount, size_t key, size_t page) {
+    while (page + 1 < pageCount && pages[page + 1] <= key) ++page;
+    return page;
+}
+
+static double keyUnits(const uint16_t* times, size_t key, size_t page) {
+    return static_cast<double>(page) * PAGE_UNITS + times[key];
+}
+
+// Index of the last key at or before time, starting from a cached key.
+// Returns the time units of that key and of the next one (if any).
+static size_t findQuantizedKey(const uint16_t* times, const uint32_t* pages, size_t pageCount, size_t count,
+                               double units, size_t key, double& keyTime, double& nextTime) {
+    if (key >= count) key = 0;
+    size_t page = static_cast<size_t>(std::upper_bound(pages, pages + pageCount, key) - pages) - 1;
+    if (keyUnits(times, key, page) > units) {
+        key = 0;
+        page = findPage(pages, pageCount, 0, 0);
+    }
+
+    keyTime = keyUnits(times, key, page);
+    nextTime = keyTime;
+    while (key + 1 < count) {
+        size_t nextPage = findPage(pages, pageCount, key + 1, page);
+        nextTime = keyUnits(times, key + 1, nextPage);
+        if (nextTime > units) break;
+
+        ++key;
+        page = nextPage;
+        keyTime = nextTime;
+    }
+    return key;
+}
+
+CompressedClip::CompressedClip()
+    : duration(0.0f), timeStep(1.0), pageCount(1), tolerance(DEFAULT_TOLERANCE), sourceKeyCount(0), sourceSize(0) {}
+
+void CompressedClip::clear() {
+    rotationTracks.clear();
+    translationTracks.clear();
+    rotationTimes.clear();
+    rotationValues.clear();
+    translationTimes.clear();
+    translationValues.clear();
+    rotationPages.clear();
+    translationPages.clear();
+    translationMins.clear();
+    translationSteps.clear();
+    duration = 0.0f;
+    timeStep = 1.0;
+    pageCount = 1;
+    sourceKeyCount = 0;
+    sourceSize = 0;
+}
+
+// Getters for the clip extent and compression results
+bool CompressedClip::isEmpty() const { return rotationTracks.empty(); }
+size_t CompressedClip::getJointCount() const { return rotationTracks.size(); }
+float CompressedClip::getDuration() const { return duration; }
+float CompressedClip::getTolerance() const { return tolerance; }
+size_t CompressedClip::getSourceKeyCount() const { return sourceKeyCount; }
+size_t CompressedClip::getKeyCount() const { return rotationTimes.size() + translationTimes.size(); }
+size_t CompressedClip::getSourceSize() const { return sourceSize; }
+
+size_t CompressedClip::getCompressedSize() const {
+    return (rotationTracks.size() + translationTracks.size()) * sizeof(Track) +
+           (rotationTimes.size() + rotationValues.size() + translationTimes.size() + translationValues.size()) * sizeof(uint16_t) +
+           (rotationPages.size() + translationPages.size()) * sizeof(uint32_t) +
+           (translationMins.size() + translationSteps.size()) * sizeof(glm::vec3);
+}
+
+size_t CompressedClip::getMemoryUsage() const {
+    return (rotationTracks.capacity() + translationTracks.capacity()) * sizeof(Track) +
+           (rotationTimes.capacity() + rotationValues.capacity() + translationTimes.capacity() + translationValues.capacity()) * sizeof(uint16_t) +
+           (rotationPages.capacity() + translationPages.capacity()) * sizeof(uint32_t) +
+           (translationMins.capacity() + translationSteps.capacity()) * sizeof(glm::vec3);
+}
+
+bool CompressedClip::hasRotationTrack(int jointIndex) const {
+    return jointIndex >= 0 && jointIndex < static_cast<int>(rotationTracks.size()) && rotationTracks[jointIndex].keyCount > 0;
+}
+
+bool CompressedClip::hasTranslationTrack(int jointIndex) const {
+    return jointIndex >= 0 && jointIndex < static_cast<int>(translationTracks.size()) && translationTracks[jointIndex].keyCount > 0;
+}
+
+uint32_t CompressedClip::quantizeTime(float time) const {
+    return static_cast<uint32_t>(std::llround(std::min(std::max(time / timeStep, 0.0), MAX_TIME_UNITS)));
+}
+
+void CompressedClip::addPages(const std::vector<uint32_t>& keptTimes, std::vector<uint32_t>& pages) const {
+    size_t key = 0;
+    for (size_t page = 0; page < pageCount; ++page) {
+        while (key < keptTimes.size() && keptTimes[key] / PAGE_UNITS < page) ++key;
+        pages.push_back(static_cast<uint32_t>(key));
+    }
+}
+
+void CompressedClip::encodeRotation(const glm::quat& rotation, uint16_t* out) {
+    float components[4] = { rotation.x, rotation.y, rotation.z, rotation.w };
+
+    int largest = 0;
+    for (int c = 1; c < 4; ++c) {
+        if (std::fabs(components[c]) > std::fabs(components[largest])) largest = c;
+    }
+
+    // q and -q are the same rotation; keep the dropped component positive
+    float sign = components[largest] < 0.0f ? -1.0f : 1.0f;
+
+    uint16_t values[3];
+    for (int c = 0, i = 0; c < 4; ++c) {
+        if (c == largest) continue;
+        float normalized = (sign * components[c] / SMALLEST_THREE_RANGE) * 0.5f + 0.5f;
+        values[i++] = static_cast<uint16_t>(std::lround(glm::clamp(normalized, 0.0f, 1.0f) * ROTATION_UNITS));
+    }
+
+    // The 2-bit index rides in the top bits of the first two values
+    out[0] = static_cast<uint16_t>(values[0] | ((largest & 1) << 15));
+    out[1] = static_cast<uint16_t>(values[1] | ((largest >> 1) << 15));
+    out[2] = values[2];
+}
+
+glm::quat CompressedClip::decodeRotation(const uint16_t* in) {
+    int largest = (in[0] >> 15) | ((in[1] >> 15) << 1);
+
+    float components[4];
+    float sumSquares = 0.0f;
+    for (int c = 0, i = 0; c < 4; ++c) {
+        if (c == largest) continue;
+        float value = ((in[i++] & 0x7fff) / ROTATION_UNITS - 0.5f) * 2.0f * SMALLEST_THREE_RANGE;
+        components[c] = value;
+        sumSquares += value * value;
+    }
+    components[largest] = std::sqrt(std::max(0.0f, 1.0f - sumSquares));
+
+    return glm::quat(components[3], components[0], components[1], components[2]);
+}
+
+bool CompressedClip::compress(const AnimationClip& clip, const SkeletalModel& model, float tolerance) {
+    clear();
+    if (clip.isEmpty()) return false;
+
+    this->tolerance = tolerance;
+    duration = clip.getDuration();
+
+    // A short clip spreads one page over its duration; a long take needs a
+    // finer unit than that to keep neighbouring keys apart
+    float minInterval = duration;
+    for (size_t j = 0; j < clip.getJointCount(); ++j) {
+        const std::vector<float>* trackTimes[2] = { &clip.getRotationKeyTimes(static_cast<int>(j)),
+                                                    &clip.getTranslationKeyTimes(static_cast<int>(j)) };
+        for (const std::vector<float>* times : trackTimes) {
+            for (size_t k = 1; k < times->size(); ++k) {
+                float interval = (*times)[k] - (*times)[k - 1];
+                if (interval > 0.0f) minInterval = std::min(minInterval, interval);
+            }
+        }
+    }
+
+    timeStep = duration > 0.0f ? std::min(static_cast<double>(duration) / UINT16_UNITS,
+                                          static_cast<double>(minInterval) / TIME_UNITS_PER_INTERVAL) : 1.0;
+    if (duration / timeStep > MAX_TIME_UNITS) {
+        std::cerr << "Clip too long to compress: " << duration << " s with keys " << minInterval << " s apart" << std::endl;
+        clear();
+        return false;
+    }
+    pageCount = quantizeTime(duration) / PAGE_UNITS + 1;
+
+    // Longest joint chain, and how far below each joint its subtree reaches
+    const std::vector<int>& parents = model.getParentIndices();
+    const std::vector<int>& order = model.getEvaluationOrder();
+    size_t modelJoints = std::min(parents.size(), order.size());
+
+    std::vector<int> depths(modelJoints, 1);
+    std::vector<float> extents(modelJoints, 0.0f);
+    int maxDepth = 1;
+
+    for (size_t k = 0; k < modelJoints; ++k) {
+        int joint = order[k];
+        if (parents[joint] >= 0) depths[joint] = depths[parents[joint]] + 1;
+        maxDepth = std::max(maxDepth, depths[joint]);
+    }
+
+    for (size_t k = modelJoints; k-- > 0;) {
+        int joint = order[k];
+        float boneLength = glm::length(model.getJointTranslation(joint));
+        if (extents[joint] == 0.0f) extents[joint] = boneLength; // A leaf's tip
+        if (parents[joint] >= 0) {
+            extents[parents[joint]] = std::max(extents[parents[joint]], boneLength + extents[joint]);
+        }
+    }
+
+    float jointTolerance = tolerance / maxDepth;
+    size_t jointCount = clip.getJointCount();
+
+    rotationTracks.assign(jointCount, Track());
+    translationTracks.assign(jointCount, Track());
+    translationMins.assign(jointCount, glm::vec3(0.0f));
+    translationSteps.assign(jointCount, glm::vec3(0.0f));
+
+    for (size_t j = 0; j < jointCount; ++j) {
+        int joint = static_cast<int>(j);
+        float extent = j < modelJoints ? extents[j] : 0.0f;
+        float maxAngle = extent > 0.0f ? 2.0f * std::asin(std::min(1.0f, jointTolerance / (2.0f * extent))) : glm::pi<float>();
+
+        rotationTracks[j].firstKey = static_cast<uint32_t>(rotationTimes.size());
+        translationTracks[j].firstKey = static_cast<uint32_t>(translationTimes.size());
+
+        // Joints without a track still take their pages, so pages index by joint
+        if (clip.hasRotationTrack(joint)) compressRotationTrack(joint, clip, maxAngle);
+        else rotationPages.resize(rotationPages.size() + pageCount, 0);
+        if (clip.hasTranslationTrack(joint)) compressTranslationTrack(joint, clip, jointTolerance);
+        else translationPages.resize(translationPages.size() + pageCount, 0);
+
+        sourceKeyCount += clip.getRotationKeyTimes(joint).size() + clip.getTranslationKeyTimes(joint).size();
+        sourceSize += clip.getRotationKeyTimes(joint).size() * (sizeof(float) + sizeof(glm::quat)) +
+                      clip.getTranslationKeyTimes(joint).size() * (sizeof(float) + sizeof(glm::vec3));
+    }
+
+    return true;
+}
+
+void CompressedClip::compressRotationTrack(int joint, const AnimationClip& clip, float maxAngle) {
+    const std::vector<float>& sourceTimes = clip.getRotationKeyTimes(joint);
+    const std::vector<glm::quat>& sourceValues = clip.getRotationKeyValues(joint);
+    size_t count = sourceTimes.size();
+
+    // Reduce against the values as they will decode
+    std::vector<uint16_t> encoded(count * 3);
+    std::vector<glm::quat> keys(count);
+    std::vector<uint32_t> quantizedTimes(count);
+    std::vector<float> times(count);
+
+    for (size_t k = 0; k < count; ++k) {
+        encodeRotation(sourceValues[k], &encoded[k * 3]);
+        keys[k] = decodeRotation(&encoded[k * 3]);
+        quantizedTimes[k] = quantizeTime(sourceTimes[k]);
+        times[k] = static_cast<float>(quantizedTimes[k] * timeStep);
+    }
+
+    auto original = [&](float time) {
+        return sampleTrack(sourceTimes, sourceValues, time,
+                           [](const glm::quat& a, const glm::quat& b, float alpha) { return glm::slerp(a, b, alpha); });
+    };
+
+    std::vector<size_t> kept = reduceKeys(sourceTimes, times, keys, maxAngle, original, nlerpRotation, rotationAngle);
+
+    std::vector<uint32_t> keptTimes;
+    for (size_t k : kept) {
+        keptTimes.push_back(quantizedTimes[k]);
+        rotationTimes.push_back(static_cast<uint16_t>(quantizedTimes[k] % PAGE_UNITS));
+        rotationValues.insert(rotationValues.end(), encoded.begin() + k * 3, encoded.begin() + k * 3 + 3);
+    }
+    rotationTracks[joint].keyCount = static_cast<uint32_t>(kept.size());
+    addPages(keptTimes, rotationPages);
+}
+
+void CompressedClip::compressTranslationTrack(int joint, const AnimationClip& clip, float maxDistance) {
+    const std::vector<float>& sourceTimes = clip.getTranslationKeyTimes(joint);
+    const std::vector<glm::vec3>& sourceValues = clip.getTranslationKeyValues(joint);
+    size_t count = sourceTimes.size();
+
+    // Range reduction: 16 bits across the track's own bounding box
+    glm::vec3 minimum = sourceValues[0], maximum = sourceValues[0];
+    for (const glm::vec3& value : sourceValues) {
+        minimum = glm::min(minimum, value);
+        maximum = glm::max(maximum, value);
+    }
+    glm::vec3 step = (maximum - minimum) / UINT16_UNITS;
+    translationMins[joint] = minimum;
+    translationSteps[joint] = step;
+
+    std::vector<uint16_t> encoded(count * 3);
+    std::vector<glm::vec3> keys(count);
+    std::vector<uint32_t> quantizedTimes(count);
+    std::vector<float> times(count);
+
+    for (size_t k = 0; k < count; ++k) {
+        for (int c = 0; c < 3; ++c) {
+            float units = step[c] > 0.0f ? (sourceValues[k][c] - minimum[c]) / step[c] : 0.0f;
+            encoded[k * 3 + c] = static_cast<uint16_t>(std::lround(glm::clamp(units, 0.0f, UINT16_UNITS)));
+            keys[k][c] = minimum[c] + encoded[k * 3 + c] * step[c];
+        }
+        quantizedTimes[k] = quantizeTime(sourceTimes[k]);
+        times[k] = static_cast<float>(quantizedTimes[k] * timeStep);
+    }
+
+    auto original = [&](float time) {
+        return sampleTrack(sourceTimes, sourceValues, time,
+                           [](const glm::vec3& a, const glm::vec3& b, float alpha) { return glm::mix(a, b, alpha); });
+    };
+    auto interpolate = [](const glm::vec3& a, const glm::vec3& b, float alpha) { return glm::mix(a, b, alpha); };
+    auto distance = [](const glm::vec3& a, const glm::vec3& b) { return glm::length(a - b); };
+
+    std::vector<size_t> kept = reduceKeys(sourceTimes, times, keys, maxDistance, original, interpolate, distance);
+
+    std::vector<uint32_t> keptTimes;
+    for (size_t k : kept) {
+        keptTimes.push_back(quantizedTimes[k]);
+        translationTimes.push_back(static_cast<uint16_t>(quantizedTimes[k] % PAGE_UNITS));
+        translationValues.insert(translationValues.end(), encoded.begin() + k * 3, encoded.begin() + k * 3 + 3);
+    }
+    translationTracks[joint].keyCount = static_cast<uint32_t>(kept.size());
+    addPages(keptTimes, translationPages);
+}
+
+void CompressedClip::sample(float time, AnimationClip::Cursor& cursor, PoseBuffer& pose) const {
+    size_t jointCount = rotationTracks.size();
+    cursor.rotationKeys.resize(jointCount, 0);
+    cursor.translationKeys.resize(jointCount, 0);
+    if (pose.getJointCount() < jointCount) pose.resize(jointCount);
+
+    // Compare in time units, so keys are never converted back
+    double units = std::min(std::max(time / timeStep, 0.0), static_cast<double>(pageCount) * PAGE_UNITS);
+
+    for (size_t j = 0; j < jointCount; ++j) {
+        const Track& rotationTrack = rotationTracks[j];
+        if (rotationTrack.keyCount > 0) {
+            const uint16_t* times = &rotationTimes[rotationTrack.firstKey];
+            const uint16_t* values = &rotationValues[rotationTrack.firstKey * 3];
+            const uint32_t* pages = &rotationPages[j * pageCount];
+
+            double t0, t1;
+            size_t key = findQuantizedKey(times, pages, pageCount, rotationTrack.keyCount, units, cursor.rotationKeys[j], t0, t1);
+            cursor.rotationKeys[j] = key;
+
+            glm::quat rotation = decodeRotation(values + key * 3);
+            if (key + 1 < rotationTrack.keyCount && units > t0) {
+                float alpha = static_cast<float>((units - t0) / (t1 - t0));
+                rotation = nlerpRotation(rotation, decodeRotation(values + key * 3 + 3), alpha);
+            }
+            pose.setRotation(j, rotation);
+        }
+
+        const Track& translationTrack = translationTracks[j];
+        if (translationTrack.keyCount > 0) {
+            const uint16_t* times = &translationTimes[translationTrack.firstKey];
+            const uint16_t* values = &translationValues[translationTrack.firstKey * 3];
+            const uint32_t* pages = &translationPages[j * pageCount];
+
+            double t0, t1;
+            size_t key = findQuantizedKey(times, pages, pageCount, translationTrack.keyCount, units, cursor.translationKeys[j], t0, t1);
+            cursor.translationKeys[j] = key;
+
+            const uint16_t* v0 = values + key * 3;
+            glm::vec3 units0(v0[0], v0[1], v0[2]);
+            if (key + 1 < translationTrack.keyCount && units > t0) {
+                const uint16_t* v1 = v0 + 3;
+                float alpha = static_cast<float>((units - t0) / (t1 - t0));
+                units0 = glm::mix(units0, glm::vec3(v1[0], v1[1], v1[2]), alpha);
+            }
+            pose.setTranslation(j, translationMins[j] + units0 * translationSteps[j]);
+        }
+    }
+}
+
+float CompressedClip::measureError(const AnimationClip& original, const CompressedClip& compressed,
+                                   const SkeletalModel& model, float sampleRate) {
+    const std::vector<int>& parents = model.getParentIndices();
+    const std::vector<int>& order = model.getEvaluationOrder();
+    size_t jointCount = std::min(parents.size(), order.size());
+
+    // Joints without a track keep the skeleton's current pose
+    PoseBuffer basePose;
+    basePose.capture(model);
+
+    std::vector<bool> isLeaf(jointCount, true);
+    for (size_t j = 0; j < jointCount; ++j) {
+        if (parents[j] >= 0) isLeaf[parents[j]] = false;
+    }
+
+    AnimationClip::Cursor originalCursor, compressedCursor;
+    PoseBuffer originalPose, compressedPose;
+    std::vector<glm::mat4> originalWorld(jointCount), compressedWorld(jointCount);
+
+    auto forwardKinematics = [&](const PoseBuffer& pose, std::vector<glm::mat4>& world) {
+        for (size_t k = 0; k < jointCount; ++k) {
+            int joint = order[k];
+            glm::mat4 local = glm::translate(glm::mat4(1.0f), pose.getTranslation(joint)) *
+                              glm::mat4_cast(pose.getRotation(joint)) *
+                              glm::scale(glm::mat4(1.0f), pose.getScale(joint));
+            world[joint] = parents[joint] >= 0 ? world[parents[joint]] * local : local;
+        }
+    };
+
+    float maxError = 0.0f;
+    float duration = original.getDuration();
+    int sampleCount = static_cast<int>(std::ceil(duration * sampleRate)) + 1;
+
+    for (int s = 0; s < sampleCount; ++s) {
+        float time = std::min(duration, s / sampleRate);
+
+        originalPose = basePose;
+        compressedPose = basePose;
+        original.sample(time, originalCursor, originalPose);
+        compressed.sample(time, compressedCursor, compressedPose);
+
+        forwardKinematics(originalPose, originalWorld);
+        forwardKinematics(compressedPose, compressedWorld);
+
+        for (size_t j = 0; j < jointCount; ++j) {
+            maxError = std::max(maxError, glm::length(glm::vec3(originalWorld[j][3] - compressedWorld[j][3])));
+
+            // Leaf tips: the bone continued past the joint
+            if (isLeaf[j]) {
+                glm::vec4 tip(basePose.getTranslation(j), 1.0f);
+                maxError = std::max(maxError, glm::length(glm::vec3(originalWorld[j] * tip - compressedWorld[j] * tip)));
+            }
+        }
+    }
+
+    return maxError;
+}
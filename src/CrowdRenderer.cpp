@@ -0,0 +1,147 @@
+#include "CrowdRenderer.h"
+#include "WorkerPool.h"
+
+#include <algorithm>
+#include <chrono>
+
+CrowdRenderer::CrowdRenderer()
+    : enabled(false), crowdBuffer(0), crowdTexture(0), maxTexels(0),
+      instanceCount(0), drawCallCount(0), uploadSize(0), time(0.0) {}
+
+CrowdRenderer::~CrowdRenderer() {
+    if (crowdTexture) glDeleteTextures(1, &crowdTexture);
+    if (crowdBuffer) glDeleteBuffers(1, &crowdBuffer);
+}
+
+// Getter and setter for crowd mode
+bool CrowdRenderer::isEnabled() const { return enabled; }
+void CrowdRenderer::setEnabled(bool enabled) { this->enabled = enabled; }
+
+// Getters for the last draw
+size_t CrowdRenderer::getInstanceCount() const { return instanceCount; }
+size_t CrowdRenderer::getDrawCallCount() const { return drawCallCount; }
+size_t CrowdRenderer::getUploadSize() const { return uploadSize; }
+double CrowdRenderer::getTime() const { return time; }
+
+std::vector<Shape*> CrowdRenderer::draw(const std::vector<Shape*>& shapes, GLuint skinningProgram) {
+    auto start = std::chrono::steady_clock::now();
+
+    characters.clear();
+    draws.clear();
+    instanceCount = drawCallCount = uploadSize = 0;
+    time = 0.0;
+
+    if (!enabled || skinningProgram == 0) return shapes;
+
+    if (!crowdBuffer) {
+        glGenBuffers(1, &crowdBuffer);
+        glGenTextures(1, &crowdTexture);
+        glBindTexture(GL_TEXTURE_BUFFER, crowdTexture);
+        glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, crowdBuffer);
+        glBindTexture(GL_TEXTURE_BUFFER, 0);
+        glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &maxTexels);
+    }
+
+    std::vector<Shape*> remaining;
+    for (Shape* shape : shapes) {
+        ImportCharacter* character = dynamic_cast<ImportCharacter*>(shape);
+        if (character && character->usesGPUSkinning() && !character->getAsset()->getFaces().empty() &&
+            character->getCrowdTexelCount() <= static_cast<size_t>(maxTexels)) {
+            // Keeps the character's buffer bookkeeping as draw() would; no skinning on this path
+            character->updateMeshVertices();
+            characters.push_back(character);
+        } else {
+            remaining.push_back(shape);
+        }
+    }
+    if (characters.empty()) return remaining;
+
+    // Characters drawn by the same call end up next to each other
+    std::stable_sort(characters.begin(), characters.end(), [](const ImportCharacter* a, const ImportCharacter* b) {
+        if (a->getAsset() != b->getAsset()) return a->getAsset() < b->getAsset();
+        return a->getSkinningMethod() < b->getSkinningMethod();
+    });
+
+    glUseProgram(skinningProgram);
+    glUniform1i(glGetUniformLocation(skinningProgram, "useCrowd"), 1);
+    glUniform1i(glGetUniformLocation(skinningProgram, "useVertexColor"), 1);
+    glUniform1i(glGetUniformLocation(skinningProgram, "useLighting"), 1);
+    glUniform1i(glGetUniformLocation(skinningProgram, "crowdData"), CROWD_TEXTURE_UNIT);
+    glActiveTexture(GL_TEXTURE0 + CROWD_TEXTURE_UNIT);
+    glBindTexture(GL_TEXTURE_BUFFER, crowdTexture);
+
+    // Split into draws by asset and method, and into uploads by the texel limit
+    texelOffsets.resize(characters.size());
+    size_t firstDraw = 0, texelCount = 0;
+
+    for (size_t i = 0; i < characters.size(); ++i) {
+        const ImportCharacter* character = characters[i];
+        const CharacterAsset* asset = character->getAsset().get();
+        bool dualQuaternion = character->getSkinningMethod() == ImportCharacter::DUAL_QUATERNION;
+        size_t stride = character->getCrowdTexelCount();
+
+        if (texelCount + stride > static_cast<size_t>(maxTexels)) {
+            flush(skinningProgram, firstDraw, texelCount);
+            firstDraw = draws.size();
+            texelCount = 0;
+        }
+
+        if (draws.size() == firstDraw || draws.back().asset != asset || draws.back().dualQuaternion != dualQuaternion) {
+            CrowdDraw crowdDraw = { asset, dualQuaternion, i, 0, texelCount, stride };
+            draws.push_back(crowdDraw);
+        }
+
+        ++draws.back().characterCount;
+        texelOffsets[i] = texelCount;
+        texelCount += stride;
+    }
+    flush(skinningProgram, firstDraw, texelCount);
+
+    glUniform1i(glGetUniformLocation(skinningProgram, "useCrowd"), 0);
+    glUniform1i(glGetUniformLocation(skinningProgram, "useVertexColor"), 0);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+    glActiveTexture(GL_TEXTURE0);
+    glBindVertexArray(0);
+
+    instanceCount = characters.size();
+    time = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return remaining;
+}
+
+void CrowdRenderer::flush(GLuint skinningProgram, size_t firstDraw, size_t texelCount) {
+    if (firstDraw == draws.size()) return;
+
+    // Each character writes only its own texels
+    size_t firstCharacter = draws[firstDraw].firstCharacter;
+    size_t lastCharacter = draws.back().firstCharacter + draws.back().characterCount;
+    texels.resize(texelCount);
+
+    WorkerPool::getInstance().parallelFor(lastCharacter - firstCharacter, CHARACTERS_PER_CHUNK,
+        [this, firstCharacter](size_t begin, size_t end) {
+            for (size_t i = firstCharacter + begin; i < firstCharacter + end; ++i) {
+                characters[i]->writeCrowdTexels(&texels[texelOffsets[i]]);
+            }
+        });
+
+    // Orphan the previous frame's store rather than wait for the GPU to finish with it
+    glBindBuffer(GL_TEXTURE_BUFFER, crowdBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, texelCount * sizeof(glm::vec4), texels.data(), GL_STREAM_DRAW);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    uploadSize += texelCount * sizeof(glm::vec4);
+
+    GLint baseLoc = glGetUniformLocation(skinningProgram, "crowdBase");
+    GLint strideLoc = glGetUniformLocation(skinningProgram, "crowdStride");
+    GLint methodLoc = glGetUniformLocation(skinningProgram, "useDualQuaternions");
+
+    for (size_t d = firstDraw; d < draws.size(); ++d) {
+        const CrowdDraw& crowdDraw = draws[d];
+        glUniform1i(baseLoc, static_cast<GLint>(crowdDraw.firstTexel));
+        glUniform1i(strideLoc, static_cast<GLint>(crowdDraw.stride));
+        glUniform1i(methodLoc, crowdDraw.dualQuaternion ? 1 : 0);
+
+        glBindVertexArray(crowdDraw.asset->getSkinnedVAO());
+        glDrawElementsInstanced(GL_TRIANGLES, static_cast<GLsizei>(crowdDraw.asset->getFaces().size() * 3),
+                                GL_UNSIGNED_INT, 0, static_cast<GLsizei>(crowdDraw.characterCount));
+        ++drawCallCount;
+    }
+}
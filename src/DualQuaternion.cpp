@@ -0,0 +1,44 @@
+#include "DualQuaternion.h"
+
+#include <cmath>
+
+DualQuaternion::DualQuaternion()
+    : real(1.0f, 0.0f, 0.0f, 0.0f), dual(0.0f, 0.0f, 0.0f, 0.0f) {}
+
+DualQuaternion::DualQuaternion(const glm::quat& rotation, const glm::vec3& translation)
+    : real(rotation),
+      dual(glm::quat(0.0f, translation.x, translation.y, translation.z) * rotation * 0.5f) {}
+
+DualQuaternion DualQuaternion::fromMatrix(const glm::mat4& transform) {
+    glm::quat rotation = glm::normalize(glm::quat_cast(glm::mat3(transform)));
+    return DualQuaternion(rotation, glm::vec3(transform[3]));
+}
+
+glm::vec3 DualQuaternion::getTranslation() const {
+    // t = 2 * dual * conjugate(real)
+    glm::quat t = dual * glm::conjugate(real) * 2.0f;
+    return glm::vec3(t.x, t.y, t.z);
+}
+
+void DualQuaternion::normalize() {
+    float length = std::sqrt(glm::dot(real, real));
+    if (length <= 0.0f) return;
+
+    real = real * (1.0f / length);
+    dual = dual * (1.0f / length);
+}
+
+glm::vec3 DualQuaternion::transformPoint(const glm::vec3& point) const {
+    glm::vec3 r(real.x, real.y, real.z);
+    glm::vec3 d(dual.x, dual.y, dual.z);
+
+    // Rotation by real plus the translation 2 * (r.w * d - d.w * r + r x d),
+    // written with cross products only (the same form as the shader)
+    glm::vec3 rotated = point + 2.0f * glm::cross(r, glm::cross(r, point) + real.w * point);
+    return rotated + 2.0f * (real.w * d - dual.w * r + glm::cross(r, d));
+}
+
+glm::vec3 DualQuaternion::transformVector(const glm::vec3& vector) const {
+    glm::vec3 r(real.x, real.y, real.z);
+    return vector + 2.0f * glm::cross(r, glm::cross(r, vector) + real.w * vector);
+}
@@ -1,5 +1,10 @@
 #include "FileImporter.h"
 
+constexpr float FileImporter::PRUNING_PROBE_ANGLE;
+constexpr float FileImporter::BVH_FIT_SIZE;
+
+std::map<std::string, std::weak_ptr<const CharacterAsset>> FileImporter::characterAssets;
+
 // Read control points from a file
 std::vector<glm::vec3> FileImporter::readCps(std::istream &file, unsigned dim) {    
    
@@ -330,13 +335,58 @@ int FileImporter::importCharacterFile(ShapeManager& shapeManager) {
 		newShapeType[i] = std::tolower(newShapeType[i]);
 	}
 							
-        std::vector<glm::vec3> vertices;
+	// Characters imported from the same files with the same weight settings share one asset
+	std::string assetKey = getCharacterAssetKey(selectedFile);
+
+	// Drop assets no character holds any more, or edited files would pile up keys
+	for (auto it = characterAssets.begin(); it != characterAssets.end();) {
+		if (it->second.expired()) it = characterAssets.erase(it);
+		else ++it;
+	}
+
+	std::shared_ptr<const CharacterAsset> asset = characterAssets[assetKey].lock();
+	if (!asset) {
+		asset = loadCharacterAsset(selectedFile);
+		if (!asset) return 0;
+		characterAssets[assetKey] = asset;
+	}
+
+			ImportCharacter* importCharacter = new ImportCharacter(0.0f, 0.0f, 0.0f, 1.0f, 12, shapeManager.incrementShapeCounter());
+
+			// Only the joints are per character; buffers are built on the first draw
+			importCharacter->setAsset(asset);
+			asset->createSkeleton(importCharacter->getSkeletalModel());
+			importCharacter->getSkeletalModel().updateCurrentJointToWorldTransforms();
+
+			// Add the ImportCharacter object to ShapeManager
+			shapeManager.addShape(importCharacter);	
+
+			// Add ImportCharacter to your list of shapes or render it directly
+
+			shapeManager.setSelectedShapeByLastAdded();  // Select the last shape added
+			shapeManager.getSelectedShape()->setShapeType(newShapeType); 
+			
+
+
+		}
+	
+
+	return 1;
+
+}
+
+
+
+
+std::shared_ptr<const CharacterAsset> FileImporter::loadCharacterAsset(const std::string& selectedFile) {
+
+	std::vector<glm::vec3> vertices;
 	std::vector<std::vector<int>> faces;
 			
 	std::ifstream file(selectedFile);
 	if (!file.is_open()) {
 		std::cerr << "Unable to open file: " << selectedFile << std::endl;
-		return 0;
+		return nullptr;
 	}
 
 	std::string line;
@@ -372,14 +422,13 @@ int FileImporter::importCharacterFile(ShapeManager& shapeManager) {
 		selectedFileSkel = selectedFileSkel + ".skel";				
 	}
 
-	Joint* rootJoint;
-	std::vector<Joint*> joints;
+	std::vector<glm::mat4> jointTransforms;
 	std::vector<int> parentIndices;
 
 	std::ifstream fileSkel(selectedFileSkel);
 	if (!fileSkel.is_open()) {
 		std::cerr << "Unable to open .skel file: " << selectedFileSkel << std::endl;
-		return 0;
+		return nullptr;
 	} else {
 
 				std::string lineSkel;
@@ -395,22 +444,10 @@ int FileImporter::importCharacterFile(ShapeManager& shapeManager) {
 					skeletonString.str(lineSkel);
 					skeletonString >> x >> y >> z >> parentIndex;
 
-					Joint *joint = new Joint;
-                                       joint->setTransform(glm::translate(glm::mat4(1.0f), glm::vec3(x, y, z)));
-
-					joints.push_back(joint);
+					jointTransforms.push_back(glm::translate(glm::mat4(1.0f), glm::vec3(x, y, z)));
 					parentIndices.push_back(parentIndex);
 
 				}
-
-
-				for (size_t i = 1; i < joints.size(); ++i) {
-					int parentIndex = parentIndices[i];
-					joints[parentIndex]->addChild(joints[i]);
-				}
-
-				rootJoint = joints.front();
-
 			}
 
 			fileSkel.close();
@@ -432,7 +469,7 @@ int FileImporter::importCharacterFile(ShapeManager& shapeManager) {
 			std::ifstream fileAttach(selectedFileAttach);
 			if (!fileAttach.is_open()) {
 				std::cerr << "Unable to open .skel file: " << selectedFileAttach << std::endl;
-				return 0;
+				return nullptr;
 			} else {
 
 				// Read the attachment weights
@@ -459,44 +496,86 @@ int FileImporter::importCharacterFile(ShapeManager& shapeManager) {
 
 			}
 			
-			// Get the shape type from the filename without the extension
-			
-			ImportCharacter* importCharacter = new ImportCharacter(0.0f, 0.0f, 0.0f, 1.0f, 12, shapeManager.incrementShapeCounter());
 
-			importCharacter->setVertices(vertices);
-			importCharacter->setFaces(faces);
-			importCharacter->calculateNormals();
-			importCharacter->setBindVertices(vertices);
-			importCharacter->getSkeletalModel().setRootJoint(rootJoint);
-			importCharacter->getSkeletalModel().setJoints(joints);
-			importCharacter->setAttachments(attachments);
+			// Keep the largest skinInfluenceLimit weights per vertex, quantized
+			SkinWeights fullAttachments;
+			fullAttachments.setFromDense(attachments);
 
-			importCharacter->getSkeletalModel().computeBindWorldToJointTransforms();
-			importCharacter->getSkeletalModel().updateCurrentJointToWorldTransforms();
+			PackedSkinWeights packedAttachments;
+			bool packed = packedAttachments.pack(fullAttachments, skinInfluenceLimit, skinWeightPrecision);
 
-                        importCharacter->setupMeshBuffer();
-                        importCharacter->setupJointBuffer();
-                        importCharacter->setupBoneBuffer();
+			SkinWeights skinAttachments;
+			if (packed) {
+				packedAttachments.unpack(skinAttachments);
+			} else {
+				std::cerr << "More than " << PackedSkinWeights::MAX_JOINTS << " joints, keeping full attachment weights" << std::endl;
+				skinAttachments = fullAttachments;
+			}
 
-			// Add the ImportCharacter object to ShapeManager
-			shapeManager.addShape(importCharacter);	
+			std::shared_ptr<const CharacterAsset> asset = std::make_shared<CharacterAsset>(
+				vertices, faces, jointTransforms, parentIndices, skinAttachments, packedAttachments);
 
-			// Add ImportCharacter to your list of shapes or render it directly
+			if (packed) {
+				std::cout << "Skin weights: " << fullAttachments.getMaxInfluencesPerVertex() << " influences, "
+				          << fullAttachments.getJointCount() * sizeof(float) << " bytes per vertex -> "
+				          << packedAttachments.getMaxInfluences() << " influences, "
+				          << packedAttachments.getBytesPerVertex() << " bytes per vertex; max position error "
+				          << measurePruningError(*asset, fullAttachments) << std::endl;
+			}
 
-			shapeManager.setSelectedShapeByLastAdded();  // Select the last shape added
-			shapeManager.getSelectedShape()->setShapeType(newShapeType); 
-			
+			return asset;
+}
 
+int FileImporter::importBvhFile(ShapeManager& shapeManager) {
+    std::string defaultPath = getExecutableDirectory() + "/data/characters/*.bvh";
+
+    const char* fileFilters[] = {"*.bvh"};
+    const char* selectedFile = tinyfd_openFileDialog(
+        "Select a BVH file",
+        defaultPath.c_str(),
+        1,
+        fileFilters,
+        "BVH Files (*.bvh)",
+        0
+    );
+
+    if (!selectedFile) {
+        std::cerr << "File selection canceled or failed." << std::endl;
+        return 0;
+    }
 
-		}
-	
+    std::string newShapeType = extractShapeType(selectedFile);
+    if (!newShapeType.empty()) newShapeType[0] = std::toupper(newShapeType[0]);
 
-	return 1;
+    ImportCharacter* importCharacter = new ImportCharacter(0.0f, 0.0f, 0.0f, 1.0f, 12, shapeManager.incrementShapeCounter());
 
-}
+    BvhImporter bvhImporter;
+    bvhImporter.setFitSize(BVH_FIT_SIZE);
+    if (!bvhImporter.load(selectedFile, importCharacter->getSkeletalModel(), importCharacter->getAnimationClip())) {
+        delete importCharacter;
+        return 0;
+    }
 
+    std::cout << "BVH: " << importCharacter->getSkeletalModel().getJoints().size() << " joints, "
+              << bvhImporter.getChannelCount() << " channels, " << bvhImporter.getFrameCount() << " frames at "
+              << 1.0f / bvhImporter.getFrameTime() << " fps" << std::endl;
 
+    // No mesh to skin: show the skeleton, posed at the first frame
+    importCharacter->setDisplayMode(ImportCharacter::SKELETAL);
+    importCharacter->getSkeletalModel().computeBindWorldToJointTransforms();
+    importCharacter->getAnimationPlayer().apply(importCharacter->getSkeletalModel());
+    importCharacter->getSkeletalModel().updateCurrentJointToWorldTransforms();
 
+    importCharacter->setupMeshBuffer();
+    importCharacter->setupJointBuffer();
+    importCharacter->setupBoneBuffer();
+
+    shapeManager.addShape(importCharacter);
+    shapeManager.setSelectedShapeByLastAdded();
+    shapeManager.getSelectedShape()->setShapeType(newShapeType);
+
+    return 1;
+}
 
 // Extract shape type from file name
 std::string FileImporter::extractShapeType(const std::string& filename) {
@@ -516,3 +595,45 @@ std::string FileImporter::extractShapeType(const std::string& filename) {
     return filename.substr(lastSlash, lastDot - lastSlash);
 }
 
+void FileImporter::setSkinInfluenceLimit(int maxInfluences) {
+	skinInfluenceLimit = maxInfluences;
+}
+
+void FileImporter::setSkinWeightPrecision(PackedSkinWeights::Precision precision) {
+	skinWeightPrecision = precision;
+}
+
+float FileImporter::measurePruningError(const CharacterAsset& asset, const SkinWeights& reference) {
+
+	// Bind pose error is always zero, so pose every joint of a scratch skeleton first
+	SkeletalModel skeletalModel;
+	asset.createSkeleton(skeletalModel);
+	size_t jointCount = skeletalModel.getJoints().size();
+
+	for (size_t i = 0; i < jointCount; ++i) {
+		skeletalModel.setJointTransform(i, PRUNING_PROBE_ANGLE, PRUNING_PROBE_ANGLE, PRUNING_PROBE_ANGLE);
+	}
+	skeletalModel.updateCurrentJointToWorldTransforms();
+
+	float error = PackedSkinWeights::computeMaxPositionError(reference, asset.getAttachments(),
+	                                                         asset.getBindVertices(),
+	                                                         skeletalModel.getSkinningPalette());
+
+	delete skeletalModel.getRootJoint(); // Deletes its children too
+	return error;
+}
+
+std::string FileImporter::getCharacterAssetKey(const std::string& objPath) {
+	std::string basePath = objPath.substr(0, objPath.find_last_of('.'));
+	std::ostringstream key;
+	key << objPath << '|' << skinInfluenceLimit << '|' << static_cast<int>(skinWeightPrecision);
+
+	// Editing any of the files on disk makes a new asset on the next import
+	const char* extensions[] = { ".obj", ".skel", ".attach" };
+	for (const char* extension : extensions) {
+		struct stat status;
+		if (stat((basePath + extension).c_str(), &status) == 0) key << '|' << status.st_mtime << '|' << status.st_size;
+	}
+
+	return key.str();
+}
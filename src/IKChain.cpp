@@ -0,0 +1,226 @@
+#include "IKChain.h"
+
+#include <algorithm>
+#include <chrono>
+
+constexpr float IKChain::DEFAULT_TOLERANCE;
+constexpr float IKChain::UNCHANGED_DISTANCE;
+
+IKChain::IKChain()
+    : target(0.0f), method(FABRIK), maxIterations(DEFAULT_MAX_ITERATIONS), tolerance(DEFAULT_TOLERANCE),
+      iterations(0), error(0.0f), solveTime(0.0), solvedTarget(0.0f), solvedPoseVersion(0), solved(false) {}
+
+bool IKChain::setJoints(const SkeletalModel& model, int endJoint, int boneCount) {
+    const std::vector<int>& parents = model.getParentIndices();
+    if (endJoint < 0 || endJoint >= static_cast<int>(parents.size()) || boneCount < 1) return false;
+
+    std::vector<int> chain(1, endJoint);
+    for (int b = 0; b < boneCount; ++b) {
+        int parent = parents[chain.back()];
+        if (parent < 0) return false;
+        chain.push_back(parent);
+    }
+
+    joints.assign(chain.rbegin(), chain.rend());
+    solved = false;
+    return true;
+}
+
+// Getters for the chain
+int IKChain::getEndJoint() const { return joints.empty() ? -1 : joints.back(); }
+int IKChain::getBoneCount() const { return joints.empty() ? 0 : static_cast<int>(joints.size()) - 1; }
+
+// Getters and setters for the target and the solver budget
+glm::vec3 IKChain::getTarget() const { return target; }
+void IKChain::setTarget(const glm::vec3& target) { this->target = target; }
+IKChain::Method IKChain::getMethod() const { return method; }
+void IKChain::setMethod(Method method) {
+    if (method != this->method) solved = false;
+    this->method = method;
+}
+int IKChain::getMaxIterations() const { return maxIterations; }
+void IKChain::setMaxIterations(int maxIterations) {
+    maxIterations = std::max(1, maxIterations);
+    if (maxIterations != this->maxIterations) solved = false;
+    this->maxIterations = maxIterations;
+}
+float IKChain::getTolerance() const { return tolerance; }
+void IKChain::setTolerance(float tolerance) {
+    tolerance = std::max(0.0f, tolerance);
+    if (tolerance != this->tolerance) solved = false;
+    this->tolerance = tolerance;
+}
+
+// Getters for the last solve
+int IKChain::getIterations() const { return iterations; }
+float IKChain::getError() const { return error; }
+double IKChain::getSolveTime() const { return solveTime; }
+
+size_t IKChain::getMemoryUsage() const {
+    return joints.capacity() * sizeof(int) + (positions.capacity() + originalPositions.capacity()) * sizeof(glm::vec3) +
+           boneLengths.capacity() * sizeof(float) + worldRotations.capacity() * sizeof(glm::quat);
+}
+
+bool IKChain::solve(SkeletalModel& model) {
+    auto start = std::chrono::steady_clock::now();
+    iterations = 0;
+
+    if (joints.size() < 2 || joints.back() >= static_cast<int>(model.getJoints().size())) {
+        error = 0.0f;
+        solveTime = 0.0;
+        return false;
+    }
+
+    // Same target on the same pose gives the same answer
+    if (solved && target == solvedTarget && model.getPoseVersion() == solvedPoseVersion) {
+        solveTime = 0.0;
+        return error <= tolerance;
+    }
+
+    // One FK pass (only the subtrees changed since the last one) for the start positions
+    model.updateCurrentJointToWorldTransforms();
+
+    size_t n = joints.size();
+    positions.resize(n);
+    boneLengths.resize(n - 1);
+    for (size_t i = 0; i < n; ++i) {
+        positions[i] = glm::vec3(model.getJointToWorldTransform(joints[i])[3]);
+    }
+    for (size_t i = 0; i + 1 < n; ++i) {
+        boneLengths[i] = glm::length(positions[i + 1] - positions[i]);
+    }
+    originalPositions = positions;
+
+    error = glm::length(positions.back() - target);
+    if (error > tolerance) {
+        if (method == CCD) solveCCD();
+        else solveFABRIK();
+
+        // An unreachable target solves to the pose the chain already has
+        float moved = 0.0f;
+        for (size_t i = 0; i < n; ++i) {
+            moved = std::max(moved, glm::length(positions[i] - originalPositions[i]));
+        }
+        if (moved > UNCHANGED_DISTANCE) applyRotations(model);
+    }
+
+    solvedTarget = target;
+    solvedPoseVersion = model.getPoseVersion();
+    solved = true;
+
+    solveTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return error <= tolerance;
+}
+
+void IKChain::solveCCD() {
+    size_t n = positions.size();
+
+    while (iterations < maxIterations && error > tolerance) {
+        ++iterations;
+
+        // From the joint nearest the end up: turn the rest of the chain onto the target
+        for (size_t i = n - 1; i-- > 0;) {
+            glm::quat rotation = shortestArc(positions[n - 1] - positions[i], target - positions[i]);
+            for (size_t k = i + 1; k < n; ++k) {
+                positions[k] = positions[i] + rotation * (positions[k] - positions[i]);
+            }
+        }
+
+        error = glm::length(positions.back() - target);
+    }
+}
+
+// Unit vector from a to b, or the bone's original direction if they coincide
+static glm::vec3 boneDirection(const glm::vec3& a, const glm::vec3& b, const glm::vec3& fallback) {
+    glm::vec3 d = b - a;
+    float length = glm::length(d);
+    return length > 1e-8f ? d / length : fallback;
+}
+
+void IKChain::solveFABRIK() {
+    size_t n = positions.size();
+    glm::vec3 base = positions[0];
+
+    float reach = 0.0f;
+    for (float length : boneLengths) reach += length;
+
+    // Out of reach: straighten the chain toward the target
+    if (glm::length(target - base) >= reach) {
+        iterations = 1;
+        for (size_t i = 0; i + 1 < n; ++i) {
+            glm::vec3 fallback = boneDirection(originalPositions[i], originalPositions[i + 1], glm::vec3(0, 1, 0));
+            positions[i + 1] = positions[i] + boneLengths[i] * boneDirection(positions[i], target, fallback);
+        }
+        error = glm::length(positions.back() - target);
+        return;
+    }
+
+    while (iterations < maxIterations && error > tolerance) {
+        ++iterations;
+
+        // Backward: pin the end to the target and pull each joint after it
+        positions[n - 1] = target;
+        for (size_t i = n - 1; i-- > 0;) {
+            glm::vec3 fallback = boneDirection(originalPositions[i + 1], originalPositions[i], glm::vec3(0, -1, 0));
+            positions[i] = positions[i + 1] + boneLengths[i] * boneDirection(positions[i + 1], positions[i], fallback);
+        }
+
+        // Forward: pin the base back in place
+        positions[0] = base;
+        for (size_t i = 0; i + 1 < n; ++i) {
+            glm::vec3 fallback = boneDirection(originalPositions[i], originalPositions[i + 1], glm::vec3(0, 1, 0));
+            positions[i + 1] = positions[i] + boneLengths[i] * boneDirection(positions[i], positions[i + 1], fallback);
+        }
+
+        error = glm::length(positions.back() - target);
+    }
+}
+
+void IKChain::applyRotations(SkeletalModel& model) {
+    size_t n = joints.size();
+
+    // Reads the transforms from before this solve: FK has not run since
+    worldRotations.resize(n);
+    for (size_t i = 0; i < n; ++i) {
+        worldRotations[i] = worldRotation(model.getJointToWorldTransform(joints[i]));
+    }
+
+    // The chain root's parent does not move
+    int rootParent = model.getParentIndices()[joints[0]];
+    glm::quat parentRotation = rootParent >= 0 ? worldRotation(model.getJointToWorldTransform(rootParent))
+                                               : glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+
+    // Turn each joint by the swing that takes its bone to the solved direction
+    for (size_t i = 0; i + 1 < n; ++i) {
+        glm::quat swing = shortestArc(originalPositions[i + 1] - originalPositions[i], positions[i + 1] - positions[i]);
+        glm::quat rotation = glm::normalize(swing * worldRotations[i]);
+
+        model.setJointRotation(joints[i], glm::normalize(glm::inverse(parentRotation) * rotation));
+        parentRotation = rotation;
+    }
+}
+
+glm::quat IKChain::shortestArc(const glm::vec3& from, const glm::vec3& to) {
+    float fromLength = glm::length(from), toLength = glm::length(to);
+    if (fromLength < 1e-8f || toLength < 1e-8f) return glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+
+    glm::vec3 a = from / fromLength, b = to / toLength;
+    float d = glm::dot(a, b);
+
+    // Opposite directions: half a turn about any perpendicular axis
+    if (d < -0.999999f) {
+        glm::vec3 axis = glm::cross(a, glm::vec3(1, 0, 0));
+        if (glm::length(axis) < 1e-4f) axis = glm::cross(a, glm::vec3(0, 1, 0));
+        return glm::angleAxis(glm::pi<float>(), glm::normalize(axis));
+    }
+
+    glm::vec3 axis = glm::cross(a, b);
+    return glm::normalize(glm::quat(1.0f + d, axis.x, axis.y, axis.z));
+}
+
+glm::quat IKChain::worldRotation(const glm::mat4& transform) {
+    // Drop any scale before taking the rotation
+    glm::mat3 basis(transform);
+    for (int c = 0; c < 3; ++c) basis[c] = glm::normalize(basis[c]);
+    return glm::normalize(glm::quat_cast(basis));
+}
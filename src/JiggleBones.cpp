@@ -0,0 +1,399 @@
+#include "JiggleBones.h"
+#include "IKChain.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+// The vector paths use GCC/Clang target attributes, as in SkinningKernel;
+// the CPU is checked before they are ever called.
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define JIGGLE_BONES_X86 1
+#include <immintrin.h>
+#else
+#define JIGGLE_BONES_X86 0
+#endif
+
+const double JiggleBones::FIXED_SUBSTEP = 1.0 / 120.0;
+constexpr float JiggleBones::DEFAULT_STIFFNESS;
+constexpr float JiggleBones::MAX_STIFFNESS;
+constexpr float JiggleBones::DEFAULT_DAMPING;
+constexpr float JiggleBones::SLEEP_DISTANCE;
+
+JiggleBones::JiggleBones()
+    : gravity(0.0f, -9.8f, 0.0f), instructionSet(SkinningKernel::detectInstructionSet()),
+      accumulator(0.0), needsReset(true), sleeping(false), appliedPoseVersion(0),
+      substepCount(0), time(0.0) {}
+
+bool JiggleBones::addJoint(const SkeletalModel& model, int jointIndex, float stiffness, float damping) {
+    const std::vector<int>& parentIndices = model.getParentIndices();
+    const std::vector<int>& order = model.getEvaluationOrder();
+    if (jointIndex < 0 || jointIndex >= static_cast<int>(parentIndices.size()) || order.size() != parentIndices.size()) return false;
+
+    int parent = parentIndices[jointIndex];
+    if (parent < 0 || std::find(parents.begin(), parents.end(), parent) != parents.end()) return false;
+
+    // Keep parents before children, so a chain of jiggle joints is posed from its root down
+    auto rank = [&order](int joint) { return std::find(order.begin(), order.end(), joint) - order.begin(); };
+    size_t i = 0;
+    while (i < joints.size() && rank(joints[i]) < rank(jointIndex)) ++i;
+
+    glm::quat rotation = model.getJointRotation(parent);
+    joints.insert(joints.begin() + i, jointIndex);
+    parents.insert(parents.begin() + i, parent);
+    animatedRotations.insert(animatedRotations.begin() + i, rotation);
+    appliedRotations.insert(appliedRotations.begin() + i, rotation);
+    boneLengths.insert(boneLengths.begin() + i, 0.0f);
+    insertLane(i, glm::clamp(stiffness, 0.0f, MAX_STIFFNESS), glm::clamp(damping, 0.0f, 1.0f));
+
+    reset();
+    return true;
+}
+
+bool JiggleBones::removeJoint(SkeletalModel& model, int jointIndex) {
+    auto found = std::find(joints.begin(), joints.end(), jointIndex);
+    if (found == joints.end()) return false;
+    size_t i = found - joints.begin();
+
+    // Left alone if the animation has set the parent since
+    if (parents[i] < static_cast<int>(model.getJoints().size()) && model.getJointRotation(parents[i]) == appliedRotations[i]) {
+        model.setJointRotation(parents[i], animatedRotations[i]);
+    }
+
+    joints.erase(joints.begin() + i);
+    parents.erase(parents.begin() + i);
+    animatedRotations.erase(animatedRotations.begin() + i);
+    appliedRotations.erase(appliedRotations.begin() + i);
+    boneLengths.erase(boneLengths.begin() + i);
+    eraseLane(i);
+
+    sleeping = false;
+    return true;
+}
+
+void JiggleBones::clear(SkeletalModel& model) {
+    while (!joints.empty()) removeJoint(model, joints.back());
+}
+
+// Getters for the jiggle joints
+const std::vector<int>& JiggleBones::getJoints() const { return joints; }
+bool JiggleBones::isEmpty() const { return joints.empty(); }
+
+// Getters and setters for the springs
+float JiggleBones::getStiffness(size_t i) const { return stiffness[i]; }
+void JiggleBones::setStiffness(size_t i, float stiffness) {
+    this->stiffness[i] = glm::clamp(stiffness, 0.0f, MAX_STIFFNESS);
+    sleeping = false;
+}
+float JiggleBones::getDamping(size_t i) const { return damping[i]; }
+void JiggleBones::setDamping(size_t i, float damping) {
+    this->damping[i] = glm::clamp(damping, 0.0f, 1.0f);
+    sleeping = false;
+}
+
+// Getter and setter for gravity
+glm::vec3 JiggleBones::getGravity() const { return gravity; }
+void JiggleBones::setGravity(const glm::vec3& gravity) {
+    this->gravity = gravity;
+    sleeping = false;
+}
+
+// Getter and setter for the stepping path
+SkinningKernel::InstructionSet JiggleBones::getInstructionSet() const { return instructionSet; }
+void JiggleBones::setInstructionSet(SkinningKernel::InstructionSet set) {
+    instructionSet = std::min(set, SkinningKernel::detectInstructionSet());
+}
+
+void JiggleBones::reset() {
+    needsReset = true;
+    sleeping = false;
+}
+
+// Getters for the last update
+int JiggleBones::getSubstepCount() const { return substepCount; }
+bool JiggleBones::isSleeping() const { return sleeping; }
+double JiggleBones::getTime() const { return time; }
+
+size_t JiggleBones::getMemoryUsage() const {
+    return (joints.capacity() + parents.capacity()) * sizeof(int) +
+           (animatedRotations.capacity() + appliedRotations.capacity()) * sizeof(glm::quat) +
+           boneLengths.capacity() * sizeof(float) + startPositions.capacity() * sizeof(glm::vec3) +
+           (positionX.capacity() * 12 + stiffness.capacity() + damping.capacity()) * sizeof(float);
+}
+
+std::vector<std::vector<float>*> JiggleBones::getLaneArrays() {
+    return { &positionX, &positionY, &positionZ, &previousX, &previousY, &previousZ,
+             &targetX, &targetY, &targetZ, &lastTargetX, &lastTargetY, &lastTargetZ,
+             &stiffness, &damping };
+}
+
+void JiggleBones::insertLane(size_t i, float stiffness, float damping) {
+    size_t laneCount = (joints.size() + LANE_COUNT - 1) / LANE_COUNT * LANE_COUNT;
+
+    for (std::vector<float>* lanes : getLaneArrays()) {
+        lanes->insert(lanes->begin() + i, 0.0f);
+        lanes->resize(laneCount, 0.0f);
+    }
+    this->stiffness[i] = stiffness;
+    this->damping[i] = damping;
+}
+
+void JiggleBones::eraseLane(size_t i) {
+    size_t laneCount = (joints.size() + LANE_COUNT - 1) / LANE_COUNT * LANE_COUNT;
+
+    for (std::vector<float>* lanes : getLaneArrays()) {
+        lanes->erase(lanes->begin() + i);
+        lanes->resize(laneCount, 0.0f);
+    }
+}
+
+void JiggleBones::update(SkeletalModel& model, double deltaTime) {
+    auto start = std::chrono::steady_clock::now();
+    substepCount = 0;
+    time = 0.0;
+
+    size_t n = joints.size();
+    if (n == 0 || model.getJoints().empty()) return;
+    for (size_t i = 0; i < n; ++i) {
+        if (joints[i] >= static_cast<int>(model.getJoints().size())) return;
+    }
+
+    // At rest and nothing else has moved the skeleton: the parents still
+    // hold the rotations the last update gave them
+    if (sleeping && model.getPoseVersion() == appliedPoseVersion) {
+        accumulator = 0.0;
+        return;
+    }
+
+    // The spring pulls toward the animated pose, not last update's jiggled one
+    restoreAnimatedRotations(model);
+    model.updateCurrentJointToWorldTransforms();
+
+    float moved = 0.0f;
+    for (size_t i = 0; i < n; ++i) {
+        glm::vec3 target(model.getJointToWorldTransform(joints[i])[3]);
+        glm::vec3 pivot(model.getJointToWorldTransform(parents[i])[3]);
+        boneLengths[i] = glm::length(target - pivot);
+
+        targetX[i] = target.x;
+        targetY[i] = target.y;
+        targetZ[i] = target.z;
+        moved = std::max(moved, glm::length(target - glm::vec3(lastTargetX[i], lastTargetY[i], lastTargetZ[i])));
+    }
+
+    if (needsReset) {
+        for (size_t i = 0; i < n; ++i) {
+            positionX[i] = previousX[i] = lastTargetX[i] = targetX[i];
+            positionY[i] = previousY[i] = lastTargetY[i] = targetY[i];
+            positionZ[i] = previousZ[i] = lastTargetZ[i] = targetZ[i];
+        }
+        accumulator = 0.0;
+        needsReset = false;
+        moved = 0.0f;
+    }
+
+    accumulator += deltaTime;
+    while (accumulator >= FIXED_SUBSTEP && substepCount < MAX_SUBSTEPS_PER_UPDATE) {
+        accumulator -= FIXED_SUBSTEP;
+        ++substepCount;
+    }
+    if (substepCount == MAX_SUBSTEPS_PER_UPDATE) accumulator = 0.0;
+
+    startPositions.resize(n);
+    for (size_t i = 0; i < n; ++i) {
+        startPositions[i] = glm::vec3(positionX[i], positionY[i], positionZ[i]);
+    }
+
+    if (substepCount > 0) {
+        switch (instructionSet) {
+#if JIGGLE_BONES_X86
+            case SkinningKernel::AVX2: stepAVX2(substepCount); break;
+            case SkinningKernel::SSE4: stepSSE4(substepCount); break;
+#endif
+            default: stepScalar(substepCount); break;
+        }
+        lastTargetX = targetX;
+        lastTargetY = targetY;
+        lastTargetZ = targetZ;
+
+        // Padding lanes have no spring, only gravity; keep them from drifting off
+        for (size_t lane = n; lane < positionX.size(); ++lane) {
+            positionX[lane] = positionY[lane] = positionZ[lane] = 0.0f;
+            previousX[lane] = previousY[lane] = previousZ[lane] = 0.0f;
+        }
+    }
+
+    // A parent the animation moved is posed even between sub-steps, from the
+    // particles as they are
+    applyRotations(model);
+
+    for (size_t i = 0; i < n; ++i) {
+        moved = std::max(moved, glm::length(glm::vec3(positionX[i], positionY[i], positionZ[i]) - startPositions[i]));
+    }
+    sleeping = substepCount > 0 && moved < SLEEP_DISTANCE;
+    appliedPoseVersion = model.getPoseVersion();
+
+    time = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void JiggleBones::restoreAnimatedRotations(SkeletalModel& model) {
+    for (size_t i = 0; i < joints.size(); ++i) {
+        glm::quat current = model.getJointRotation(parents[i]);
+        if (current == appliedRotations[i]) {
+            model.setJointRotation(parents[i], animatedRotations[i]);
+        } else {
+            animatedRotations[i] = current;
+        }
+    }
+}
+
+void JiggleBones::applyRotations(SkeletalModel& model) {
+    const std::vector<int>& parentIndices = model.getParentIndices();
+
+    for (size_t i = 0; i < joints.size(); ++i) {
+        // Picks up the parents turned so far (only their subtrees are re-evaluated)
+        model.updateCurrentJointToWorldTransforms();
+
+        const glm::mat4& parentTransform = model.getJointToWorldTransform(parents[i]);
+        glm::vec3 pivot(parentTransform[3]);
+        glm::vec3 current(model.getJointToWorldTransform(joints[i])[3]);
+
+        // Distance constraint: the particle slides onto the sphere of the bone length
+        glm::vec3 particle(positionX[i], positionY[i], positionZ[i]);
+        glm::vec3 offset = particle - pivot;
+        float length = glm::length(offset);
+        particle = length > 1e-8f ? pivot + offset * (boneLengths[i] / length) : current;
+
+        positionX[i] = particle.x;
+        positionY[i] = particle.y;
+        positionZ[i] = particle.z;
+
+        // Turn the parent by the swing that takes the bone onto the particle
+        glm::quat swing = IKChain::shortestArc(current - pivot, particle - pivot);
+        glm::quat rotation = glm::normalize(swing * IKChain::worldRotation(parentTransform));
+
+        int grandparent = parentIndices[parents[i]];
+        glm::quat parentRotation = grandparent >= 0 ? IKChain::worldRotation(model.getJointToWorldTransform(grandparent))
+                                                    : glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+
+        appliedRotations[i] = glm::normalize(glm::inverse(parentRotation) * rotation);
+        model.setJointRotation(parents[i], appliedRotations[i]);
+    }
+
+    model.updateCurrentJointToWorldTransforms();
+}
+
+// Position Verlet with a spring toward the animated position:
+//   x' = x + (x - x_prev) * (1 - damping) + (stiffness * (target - x) + gravity) * h^2
+// Each axis is independent, so each is stepped on its own.
+void JiggleBones::stepScalar(int steps) {
+    float h2 = static_cast<float>(FIXED_SUBSTEP * FIXED_SUBSTEP);
+    float* position[3] = { positionX.data(), positionY.data(), positionZ.data() };
+    float* previous[3] = { previousX.data(), previousY.data(), previousZ.data() };
+    const float* target[3] = { targetX.data(), targetY.data(), targetZ.data() };
+    const float* lastTarget[3] = { lastTargetX.data(), lastTargetY.data(), lastTargetZ.data() };
+
+    for (int axis = 0; axis < 3; ++axis) {
+        float g = gravity[axis] * h2;
+
+        for (size_t lane = 0; lane < positionX.size(); ++lane) {
+            float x = position[axis][lane], px = previous[axis][lane];
+            float t0 = lastTarget[axis][lane], dt = target[axis][lane] - t0;
+            float k = stiffness[lane] * h2, keep = 1.0f - damping[lane];
+
+            for (int s = 1; s <= steps; ++s) {
+                float t = t0 + dt * (static_cast<float>(s) / steps);
+                float next = x + (x - px) * keep + k * (t - x) + g;
+                px = x;
+                x = next;
+            }
+
+            position[axis][lane] = x;
+            previous[axis][lane] = px;
+        }
+    }
+}
+
+#if JIGGLE_BONES_X86
+
+__attribute__((target("sse4.1")))
+void JiggleBones::stepSSE4(int steps) {
+    float h2 = static_cast<float>(FIXED_SUBSTEP * FIXED_SUBSTEP);
+    float* position[3] = { positionX.data(), positionY.data(), positionZ.data() };
+    float* previous[3] = { previousX.data(), previousY.data(), previousZ.data() };
+    const float* target[3] = { targetX.data(), targetY.data(), targetZ.data() };
+    const float* lastTarget[3] = { lastTargetX.data(), lastTargetY.data(), lastTargetZ.data() };
+
+    __m128 one = _mm_set1_ps(1.0f);
+    __m128 h2v = _mm_set1_ps(h2);
+
+    for (int axis = 0; axis < 3; ++axis) {
+        __m128 g = _mm_set1_ps(gravity[axis] * h2);
+
+        for (size_t lane = 0; lane < positionX.size(); lane += 4) {
+            __m128 x = _mm_loadu_ps(position[axis] + lane);
+            __m128 px = _mm_loadu_ps(previous[axis] + lane);
+            __m128 t0 = _mm_loadu_ps(lastTarget[axis] + lane);
+            __m128 dt = _mm_sub_ps(_mm_loadu_ps(target[axis] + lane), t0);
+            __m128 k = _mm_mul_ps(_mm_loadu_ps(&stiffness[lane]), h2v);
+            __m128 keep = _mm_sub_ps(one, _mm_loadu_ps(&damping[lane]));
+
+            for (int s = 1; s <= steps; ++s) {
+                __m128 t = _mm_add_ps(t0, _mm_mul_ps(dt, _mm_set1_ps(static_cast<float>(s) / steps)));
+                __m128 next = _mm_add_ps(x, _mm_mul_ps(_mm_sub_ps(x, px), keep));
+                next = _mm_add_ps(next, _mm_mul_ps(k, _mm_sub_ps(t, x)));
+                next = _mm_add_ps(next, g);
+                px = x;
+                x = next;
+            }
+
+            _mm_storeu_ps(position[axis] + lane, x);
+            _mm_storeu_ps(previous[axis] + lane, px);
+        }
+    }
+}
+
+__attribute__((target("avx2,fma")))
+void JiggleBones::stepAVX2(int steps) {
+    float h2 = static_cast<float>(FIXED_SUBSTEP * FIXED_SUBSTEP);
+    float* position[3] = { positionX.data(), positionY.data(), positionZ.data() };
+    float* previous[3] = { previousX.data(), previousY.data(), previousZ.data() };
+    const float* target[3] = { targetX.data(), targetY.data(), targetZ.data() };
+    const float* lastTarget[3] = { lastTargetX.data(), lastTargetY.data(), lastTargetZ.data() };
+
+    __m256 one = _mm256_set1_ps(1.0f);
+    __m256 h2v = _mm256_set1_ps(h2);
+
+    for (int axis = 0; axis < 3; ++axis) {
+        __m256 g = _mm256_set1_ps(gravity[axis] * h2);
+
+        for (size_t lane = 0; lane < positionX.size(); lane += 8) {
+            __m256 x = _mm256_loadu_ps(position[axis] + lane);
+            __m256 px = _mm256_loadu_ps(previous[axis] + lane);
+            __m256 t0 = _mm256_loadu_ps(lastTarget[axis] + lane);
+            __m256 dt = _mm256_sub_ps(_mm256_loadu_ps(target[axis] + lane), t0);
+            __m256 k = _mm256_mul_ps(_mm256_loadu_ps(&stiffness[lane]), h2v);
+            __m256 keep = _mm256_sub_ps(one, _mm256_loadu_ps(&damping[lane]));
+
+            for (int s = 1; s <= steps; ++s) {
+                __m256 t = _mm256_fmadd_ps(dt, _mm256_set1_ps(static_cast<float>(s) / steps), t0);
+                __m256 next = _mm256_fmadd_ps(_mm256_sub_ps(x, px), keep, x);
+                next = _mm256_fmadd_ps(k, _mm256_sub_ps(t, x), next);
+                next = _mm256_add_ps(next, g);
+                px = x;
+                x = next;
+            }
+
+            _mm256_storeu_ps(position[axis] + lane, x);
+            _mm256_storeu_ps(previous[axis] + lane, px);
+        }
+    }
+}
+
+#else
+
+// Never selected without x86 intrinsics
+void JiggleBones::stepSSE4(int steps) { stepScalar(steps); }
+void JiggleBones::stepAVX2(int steps) { stepScalar(steps); }
+
+#endif
@@ -0,0 +1,90 @@
+#include "MappedFile.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+MappedFile::MappedFile() : data(nullptr), size(0) {}
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+bool MappedFile::open(const std::string& path, bool sequential) {
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+        ::close(fd);
+        return false;
+    }
+
+    void* mapping = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd); // The mapping keeps the file referenced
+
+    if (mapping == MAP_FAILED) return false;
+
+    data = mapping;
+    size = static_cast<size_t>(info.st_size);
+
+    // Read front to back: read ahead, and pages behind can be dropped early.
+    // Random access: no read-ahead beyond what the reader asks for.
+    madvise(data, size, sequential ? MADV_SEQUENTIAL : MADV_RANDOM);
+    return true;
+}
+
+void MappedFile::close() {
+    if (data) munmap(data, size);
+    data = nullptr;
+    size = 0;
+}
+
+bool MappedFile::isOpen() const { return data != nullptr; }
+const unsigned char* MappedFile::getData() const { return static_cast<const unsigned char*>(data); }
+size_t MappedFile::getSize() const { return size; }
+
+void MappedFile::prefetch(size_t offset, size_t length) const {
+    if (!data || offset >= size) return;
+
+    // madvise needs a page-aligned start
+    size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size_t begin = offset - offset % pageSize;
+    size_t end = std::min(size, offset + length);
+
+    madvise(static_cast<unsigned char*>(data) + begin, end - begin, MADV_WILLNEED);
+}
+
+void MappedFile::load(size_t offset, size_t length) const {
+    if (!data || offset >= size) return;
+
+    prefetch(offset, length);
+
+    // Touch a byte of every page so each fault happens here, not in the reader
+    size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size_t end = std::min(size, offset + length);
+    const volatile unsigned char* bytes = static_cast<const unsigned char*>(data);
+    unsigned char sum = 0;
+    for (size_t i = offset - offset % pageSize; i < end; i += pageSize) sum += bytes[i];
+    sum += bytes[end - 1];
+    (void)sum;
+}
+
+void MappedFile::release(size_t offset, size_t length) const {
+    if (!data || offset >= size) return;
+
+    // Round inwards so pages shared with neighbouring data stay resident
+    size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size_t begin = (offset + pageSize - 1) / pageSize * pageSize;
+    size_t end = std::min(size, offset + length);
+    if (end < size) end -= end % pageSize;
+    if (begin >= end) return;
+
+    // The mapping is read-only, so dropped pages are simply read again from the file
+    madvise(static_cast<unsigned char*>(data) + begin, end - begin, MADV_DONTNEED);
+}
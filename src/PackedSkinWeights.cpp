@@ -0,0 +1,165 @@
+#include "PackedSkinWeights.h"
+
+#include <algorithm>
+#include <cmath>
+
+PackedSkinWeights::PackedSkinWeights()
+    : vertexCount(0), jointCount(0), maxInfluences(DEFAULT_MAX_INFLUENCES), precision(UNORM8) {}
+
+bool PackedSkinWeights::pack(const SkinWeights& weights, int maxInfluences, Precision precision) {
+    clear();
+
+    if (weights.getJointCount() > static_cast<size_t>(MAX_JOINTS)) return false;
+
+    this->maxInfluences = std::max(1, maxInfluences);
+    this->precision = precision;
+    vertexCount = weights.getVertexCount();
+    jointCount = weights.getJointCount();
+
+    size_t slotCount = vertexCount * this->maxInfluences;
+    unsigned int maxValue = (precision == UNORM16) ? 65535u : 255u;
+
+    joints.assign(slotCount, 0);
+    if (precision == UNORM16) {
+        weights16.assign(slotCount, 0);
+    } else {
+        weights8.assign(slotCount, 0);
+    }
+
+    std::vector<SkinWeights::Influence> largest(this->maxInfluences);
+    std::vector<float> values(this->maxInfluences);
+    std::vector<unsigned int> quantized(this->maxInfluences);
+
+    for (size_t v = 0; v < vertexCount; ++v) {
+        int count = weights.getLargestInfluences(v, this->maxInfluences, largest.data());
+
+        for (int k = 0; k < count; ++k) values[k] = largest[k].weight;
+        quantizeWeights(values.data(), count, maxValue, quantized.data());
+
+        for (int k = 0; k < count; ++k) {
+            size_t slot = v * this->maxInfluences + k;
+            joints[slot] = static_cast<unsigned char>(largest[k].jointIndex);
+            if (precision == UNORM16) {
+                weights16[slot] = static_cast<unsigned short>(quantized[k]);
+            } else {
+                weights8[slot] = static_cast<unsigned char>(quantized[k]);
+            }
+        }
+    }
+
+    return true;
+}
+
+void PackedSkinWeights::clear() {
+    vertexCount = 0;
+    jointCount = 0;
+    joints.clear();
+    weights8.clear();
+    weights16.clear();
+}
+
+void PackedSkinWeights::unpack(SkinWeights& out) const {
+    std::vector<unsigned int> offsets;
+    std::vector<SkinWeights::Influence> influences;
+    offsets.reserve(vertexCount + 1);
+    influences.reserve(vertexCount * maxInfluences);
+
+    offsets.push_back(0);
+    for (size_t v = 0; v < vertexCount; ++v) {
+        for (int k = 0; k < maxInfluences; ++k) {
+            float weight = getWeight(v, k);
+            if (weight == 0.0f) continue;
+
+            SkinWeights::Influence influence;
+            influence.jointIndex = joints[v * maxInfluences + k];
+            influence.weight = weight;
+            influences.push_back(influence);
+        }
+        offsets.push_back(static_cast<unsigned int>(influences.size()));
+    }
+
+    out.setFromSparse(offsets, influences, jointCount);
+}
+
+bool PackedSkinWeights::isEmpty() const { return vertexCount == 0; }
+size_t PackedSkinWeights::getVertexCount() const { return vertexCount; }
+size_t PackedSkinWeights::getJointCount() const { return jointCount; }
+int PackedSkinWeights::getMaxInfluences() const { return maxInfluences; }
+PackedSkinWeights::Precision PackedSkinWeights::getPrecision() const { return precision; }
+
+const std::vector<unsigned char>& PackedSkinWeights::getJoints() const { return joints; }
+const std::vector<unsigned char>& PackedSkinWeights::getWeights8() const { return weights8; }
+const std::vector<unsigned short>& PackedSkinWeights::getWeights16() const { return weights16; }
+
+float PackedSkinWeights::getWeight(size_t vertex, int slot) const {
+    size_t index = vertex * maxInfluences + slot;
+    if (precision == UNORM16) return weights16[index] / 65535.0f;
+    return weights8[index] / 255.0f;
+}
+
+size_t PackedSkinWeights::getBytesPerVertex() const {
+    return maxInfluences * (1 + (precision == UNORM16 ? sizeof(unsigned short) : sizeof(unsigned char)));
+}
+
+size_t PackedSkinWeights::getMemoryUsage() const {
+    return joints.capacity() + weights8.capacity() + weights16.capacity() * sizeof(unsigned short);
+}
+
+void PackedSkinWeights::quantizeWeights(const float* weights, int count, unsigned int maxValue, unsigned int* out) {
+    float sum = 0.0f;
+    for (int k = 0; k < count; ++k) sum += weights[k];
+
+    if (sum <= 0.0f) {
+        std::fill(out, out + count, 0u);
+        return;
+    }
+
+    unsigned int total = 0;
+    for (int k = 0; k < count; ++k) {
+        out[k] = static_cast<unsigned int>(std::floor(weights[k] * maxValue));
+        total += out[k];
+    }
+
+    // Hand out what flooring lost, one unit at a time, largest remainder first
+    while (total < maxValue) {
+        int best = 0;
+        float bestRemainder = -1.0f;
+        for (int k = 0; k < count; ++k) {
+            float remainder = weights[k] * maxValue - static_cast<float>(out[k]);
+            if (remainder > bestRemainder) {
+                bestRemainder = remainder;
+                best = k;
+            }
+        }
+        ++out[best];
+        ++total;
+    }
+}
+
+float PackedSkinWeights::computeMaxPositionError(const SkinWeights& reference, const SkinWeights& approximation,
+                                                 const std::vector<glm::vec3>& bindVertices,
+                                                 const std::vector<glm::mat4>& palette) {
+
+    auto skinVertex = [&](const SkinWeights& weights, size_t v) {
+        const std::vector<unsigned int>& offsets = weights.getOffsets();
+        const std::vector<SkinWeights::Influence>& influences = weights.getInfluences();
+
+        glm::vec4 bindPos(bindVertices[v], 1.0f);
+        glm::vec3 position(0.0f);
+        for (unsigned int k = offsets[v]; k < offsets[v + 1]; ++k) {
+            if (static_cast<size_t>(influences[k].jointIndex) >= palette.size()) continue;
+            position += influences[k].weight * glm::vec3(palette[influences[k].jointIndex] * bindPos);
+        }
+        return position;
+    };
+
+    size_t vertexCount = std::min(bindVertices.size(),
+                                  std::min(reference.getVertexCount(), approximation.getVertexCount()));
+
+    float maxError = 0.0f;
+    for (size_t v = 0; v < vertexCount; ++v) {
+        maxError = std::max(maxError, glm::length(skinVertex(reference, v) - skinVertex(approximation, v)));
+    }
+
+    return maxError;
+}
@@ -0,0 +1,285 @@
+#include "PoseBuffer.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__)
+#define POSE_BUFFER_SSE 1
+#include <emmintrin.h>
+#else
+#define POSE_BUFFER_SSE 0
+#endif
+
+static const float IDENTITY_POSE[] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f, 1.0f };
+
+PoseBuffer::PoseBuffer() : jointCount(0) {}
+
+PoseBuffer::PoseBuffer(size_t jointCount) : jointCount(0) {
+    resize(jointCount);
+}
+
+size_t PoseBuffer::getJointCount() const { return jointCount; }
+
+void PoseBuffer::resize(size_t jointCount) {
+    for (int c = 0; c < CHANNEL_COUNT; ++c) channels[c].resize(jointCount, IDENTITY_POSE[c]);
+    this->jointCount = jointCount;
+}
+
+void PoseBuffer::setIdentity() {
+    for (int c = 0; c < CHANNEL_COUNT; ++c) std::fill(channels[c].begin(), channels[c].end(), IDENTITY_POSE[c]);
+}
+
+size_t PoseBuffer::getMemoryUsage() const {
+    size_t floats = 0;
+    for (int c = 0; c < CHANNEL_COUNT; ++c) floats += channels[c].capacity();
+    return floats * sizeof(float);
+}
+
+float* PoseBuffer::channel(Channel c) { return channels[c].data(); }
+const float* PoseBuffer::channel(Channel c) const { return channels[c].data(); }
+
+// Getters and setters for single joints
+glm::vec3 PoseBuffer::getTranslation(size_t joint) const {
+    return glm::vec3(channels[TX][joint], channels[TY][joint], channels[TZ][joint]);
+}
+
+void PoseBuffer::setTranslation(size_t joint, const glm::vec3& translation) {
+    channels[TX][joint] = translation.x;
+    channels[TY][joint] = translation.y;
+    channels[TZ][joint] = translation.z;
+}
+
+glm::quat PoseBuffer::getRotation(size_t joint) const {
+    return glm::quat(channels[QW][joint], channels[QX][joint], channels[QY][joint], channels[QZ][joint]);
+}
+
+void PoseBuffer::setRotation(size_t joint, const glm::quat& rotation) {
+    channels[QX][joint] = rotation.x;
+    channels[QY][joint] = rotation.y;
+    channels[QZ][joint] = rotation.z;
+    channels[QW][joint] = rotation.w;
+}
+
+glm::vec3 PoseBuffer::getScale(size_t joint) const {
+    return glm::vec3(channels[SX][joint], channels[SY][joint], channels[SZ][joint]);
+}
+
+void PoseBuffer::setScale(size_t joint, const glm::vec3& scale) {
+    channels[SX][joint] = scale.x;
+    channels[SY][joint] = scale.y;
+    channels[SZ][joint] = scale.z;
+}
+
+void PoseBuffer::capture(const SkeletalModel& model) {
+    resize(model.getJoints().size());
+    for (size_t j = 0; j < jointCount; ++j) {
+        int joint = static_cast<int>(j);
+        setTranslation(j, model.getJointTranslation(joint));
+        setRotation(j, model.getJointRotation(joint));
+        setScale(j, model.getJointScale(joint));
+    }
+}
+
+void PoseBuffer::apply(SkeletalModel& model) const {
+    size_t count = std::min(jointCount, model.getJoints().size());
+    for (size_t j = 0; j < count; ++j) {
+        int joint = static_cast<int>(j);
+        model.setJointTranslation(joint, getTranslation(j));
+        model.setJointRotation(joint, getRotation(j));
+        model.setJointScale(joint, getScale(j));
+    }
+}
+
+void PoseBuffer::blend(const PoseBuffer& a, const PoseBuffer& b, float weight, PoseBuffer& out) {
+    blendPoses(a, b, nullptr, weight, out);
+}
+
+void PoseBuffer::maskedBlend(const PoseBuffer& a, const PoseBuffer& b, const std::vector<float>& mask,
+                             float weight, PoseBuffer& out) {
+    if (mask.size() < std::min(a.jointCount, b.jointCount)) {
+        blendPoses(a, b, nullptr, weight, out);
+        return;
+    }
+    blendPoses(a, b, mask.data(), weight, out);
+}
+
+void PoseBuffer::blendPoses(const PoseBuffer& a, const PoseBuffer& b, const float* mask, float weight, PoseBuffer& out) {
+    size_t count = std::min(a.jointCount, b.jointCount);
+    out.resize(count);
+
+    const float* ta[3] = { a.channel(TX), a.channel(TY), a.channel(TZ) };
+    const float* tb[3] = { b.channel(TX), b.channel(TY), b.channel(TZ) };
+    const float* sa[3] = { a.channel(SX), a.channel(SY), a.channel(SZ) };
+    const float* sb[3] = { b.channel(SX), b.channel(SY), b.channel(SZ) };
+    const float* qa[4] = { a.channel(QX), a.channel(QY), a.channel(QZ), a.channel(QW) };
+    const float* qb[4] = { b.channel(QX), b.channel(QY), b.channel(QZ), b.channel(QW) };
+    float* to[3] = { out.channel(TX), out.channel(TY), out.channel(TZ) };
+    float* so[3] = { out.channel(SX), out.channel(SY), out.channel(SZ) };
+    float* qo[4] = { out.channel(QX), out.channel(QY), out.channel(QZ), out.channel(QW) };
+
+    size_t j = 0;
+
+#if POSE_BUFFER_SSE
+    const __m128 signMask = _mm_set1_ps(-0.0f);
+    const __m128 one = _mm_set1_ps(1.0f);
+
+    for (; j + 4 <= count; j += 4) {
+        __m128 w = _mm_set1_ps(weight);
+        if (mask) w = _mm_mul_ps(w, _mm_loadu_ps(mask + j));
+
+        for (int c = 0; c < 3; ++c) {
+            __m128 t0 = _mm_loadu_ps(ta[c] + j), s0 = _mm_loadu_ps(sa[c] + j);
+            _mm_storeu_ps(to[c] + j, _mm_add_ps(t0, _mm_mul_ps(w, _mm_sub_ps(_mm_loadu_ps(tb[c] + j), t0))));
+            _mm_storeu_ps(so[c] + j, _mm_add_ps(s0, _mm_mul_ps(w, _mm_sub_ps(_mm_loadu_ps(sb[c] + j), s0))));
+        }
+
+        __m128 a4[4], b4[4];
+        __m128 dot = _mm_setzero_ps();
+        for (int c = 0; c < 4; ++c) {
+            a4[c] = _mm_loadu_ps(qa[c] + j);
+            b4[c] = _mm_loadu_ps(qb[c] + j);
+            dot = _mm_add_ps(dot, _mm_mul_ps(a4[c], b4[c]));
+        }
+
+        // Flip b into a's hemisphere by giving its weight the sign of the dot product
+        __m128 wa = _mm_sub_ps(one, w);
+        __m128 wb = _mm_xor_ps(w, _mm_and_ps(dot, signMask));
+
+        __m128 q[4];
+        __m128 lengthSquared = _mm_setzero_ps();
+        for (int c = 0; c < 4; ++c) {
+            q[c] = _mm_add_ps(_mm_mul_ps(wa, a4[c]), _mm_mul_ps(wb, b4[c]));
+            lengthSquared = _mm_add_ps(lengthSquared, _mm_mul_ps(q[c], q[c]));
+        }
+
+        __m128 inverseLength = _mm_div_ps(one, _mm_sqrt_ps(lengthSquared));
+        for (int c = 0; c < 4; ++c) _mm_storeu_ps(qo[c] + j, _mm_mul_ps(q[c], inverseLength));
+    }
+#endif
+
+    for (; j < count; ++j) {
+        float w = mask ? weight * mask[j] : weight;
+
+        for (int c = 0; c < 3; ++c) {
+            to[c][j] = ta[c][j] + w * (tb[c][j] - ta[c][j]);
+            so[c][j] = sa[c][j] + w * (sb[c][j] - sa[c][j]);
+        }
+
+        float dot = qa[0][j] * qb[0][j] + qa[1][j] * qb[1][j] + qa[2][j] * qb[2][j] + qa[3][j] * qb[3][j];
+        float wa = 1.0f - w;
+        float wb = std::copysign(w, dot);
+
+        float q[4];
+        float lengthSquared = 0.0f;
+        for (int c = 0; c < 4; ++c) {
+            q[c] = wa * qa[c][j] + wb * qb[c][j];
+            lengthSquared += q[c] * q[c];
+        }
+
+        float inverseLength = 1.0f / std::sqrt(lengthSquared);
+        for (int c = 0; c < 4; ++c) qo[c][j] = q[c] * inverseLength;
+    }
+}
+
+void PoseBuffer::makeAdditive(const PoseBuffer& pose, const PoseBuffer& reference, PoseBuffer& out) {
+
+    // Built once per layer, so this stays scalar
+    size_t count = std::min(pose.jointCount, reference.jointCount);
+    out.resize(count);
+
+    for (size_t j = 0; j < count; ++j) {
+        glm::vec3 translation = pose.getTranslation(j) - reference.getTranslation(j);
+        glm::quat rotation = glm::normalize(glm::conjugate(reference.getRotation(j)) * pose.getRotation(j));
+        glm::vec3 scale = pose.getScale(j) / reference.getScale(j);
+
+        out.setTranslation(j, translation);
+        out.setRotation(j, rotation);
+        out.setScale(j, scale);
+    }
+}
+
+void PoseBuffer::addLayer(const PoseBuffer& base, const PoseBuffer& additive, float weight,
+                          const std::vector<float>* mask, PoseBuffer& out) {
+    size_t count = std::min(base.jointCount, additive.jointCount);
+    const float* maskData = (mask && mask->size() >= count) ? mask->data() : nullptr;
+    out.resize(count);
+
+    const float* tb[3] = { base.channel(TX), base.channel(TY), base.channel(TZ) };
+    const float* td[3] = { additive.channel(TX), additive.channel(TY), additive.channel(TZ) };
+    const float* sb[3] = { base.channel(SX), base.channel(SY), base.channel(SZ) };
+    const float* sd[3] = { additive.channel(SX), additive.channel(SY), additive.channel(SZ) };
+    const float* qb[4] = { base.channel(QX), base.channel(QY), base.channel(QZ), base.channel(QW) };
+    const float* qd[4] = { additive.channel(QX), additive.channel(QY), additive.channel(QZ), additive.channel(QW) };
+    float* to[3] = { out.channel(TX), out.channel(TY), out.channel(TZ) };
+    float* so[3] = { out.channel(SX), out.channel(SY), out.channel(SZ) };
+    float* qo[4] = { out.channel(QX), out.channel(QY), out.channel(QZ), out.channel(QW) };
+
+    size_t j = 0;
+
+#if POSE_BUFFER_SSE
+    const __m128 signMask = _mm_set1_ps(-0.0f);
+    const __m128 one = _mm_set1_ps(1.0f);
+
+    for (; j + 4 <= count; j += 4) {
+        __m128 w = _mm_set1_ps(weight);
+        if (maskData) w = _mm_mul_ps(w, _mm_loadu_ps(maskData + j));
+
+        // Translations add, scales multiply
+        for (int c = 0; c < 3; ++c) {
+            _mm_storeu_ps(to[c] + j, _mm_add_ps(_mm_loadu_ps(tb[c] + j), _mm_mul_ps(w, _mm_loadu_ps(td[c] + j))));
+            __m128 scale = _mm_add_ps(one, _mm_mul_ps(w, _mm_sub_ps(_mm_loadu_ps(sd[c] + j), one)));
+            _mm_storeu_ps(so[c] + j, _mm_mul_ps(_mm_loadu_ps(sb[c] + j), scale));
+        }
+
+        // Scale the delta rotation from identity: nlerp towards it in the w >= 0 hemisphere
+        __m128 dw = _mm_loadu_ps(qd[3] + j);
+        __m128 wd = _mm_xor_ps(w, _mm_and_ps(dw, signMask));
+        __m128 d[4];
+        d[0] = _mm_mul_ps(wd, _mm_loadu_ps(qd[0] + j));
+        d[1] = _mm_mul_ps(wd, _mm_loadu_ps(qd[1] + j));
+        d[2] = _mm_mul_ps(wd, _mm_loadu_ps(qd[2] + j));
+        d[3] = _mm_add_ps(_mm_sub_ps(one, w), _mm_mul_ps(wd, dw));
+
+        __m128 lengthSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(d[0], d[0]), _mm_mul_ps(d[1], d[1])),
+                                          _mm_add_ps(_mm_mul_ps(d[2], d[2]), _mm_mul_ps(d[3], d[3])));
+        __m128 inverseLength = _mm_div_ps(one, _mm_sqrt_ps(lengthSquared));
+        for (int c = 0; c < 4; ++c) d[c] = _mm_mul_ps(d[c], inverseLength);
+
+        // base * delta
+        __m128 bx = _mm_loadu_ps(qb[0] + j), by = _mm_loadu_ps(qb[1] + j);
+        __m128 bz = _mm_loadu_ps(qb[2] + j), bw = _mm_loadu_ps(qb[3] + j);
+
+        __m128 x = _mm_add_ps(_mm_add_ps(_mm_mul_ps(bw, d[0]), _mm_mul_ps(bx, d[3])),
+                              _mm_sub_ps(_mm_mul_ps(by, d[2]), _mm_mul_ps(bz, d[1])));
+        __m128 y = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(bw, d[1]), _mm_mul_ps(bx, d[2])),
+                              _mm_add_ps(_mm_mul_ps(by, d[3]), _mm_mul_ps(bz, d[0])));
+        __m128 z = _mm_add_ps(_mm_add_ps(_mm_mul_ps(bw, d[2]), _mm_mul_ps(bx, d[1])),
+                              _mm_sub_ps(_mm_mul_ps(bz, d[3]), _mm_mul_ps(by, d[0])));
+        __m128 qw = _mm_sub_ps(_mm_sub_ps(_mm_mul_ps(bw, d[3]), _mm_mul_ps(bx, d[0])),
+                               _mm_add_ps(_mm_mul_ps(by, d[1]), _mm_mul_ps(bz, d[2])));
+
+        _mm_storeu_ps(qo[0] + j, x);
+        _mm_storeu_ps(qo[1] + j, y);
+        _mm_storeu_ps(qo[2] + j, z);
+        _mm_storeu_ps(qo[3] + j, qw);
+    }
+#endif
+
+    for (; j < count; ++j) {
+        float w = maskData ? weight * maskData[j] : weight;
+
+        for (int c = 0; c < 3; ++c) {
+            to[c][j] = tb[c][j] + w * td[c][j];
+            so[c][j] = sb[c][j] * (1.0f + w * (sd[c][j] - 1.0f));
+        }
+
+        float wd = std::copysign(w, qd[3][j]);
+        glm::quat delta(1.0f - w + wd * qd[3][j], wd * qd[0][j], wd * qd[1][j], wd * qd[2][j]);
+        glm::quat rotation = glm::quat(qb[3][j], qb[0][j], qb[1][j], qb[2][j]) * glm::normalize(delta);
+
+        qo[0][j] = rotation.x;
+        qo[1][j] = rotation.y;
+        qo[2][j] = rotation.z;
+        qo[3][j] = rotation.w;
+    }
+}
@@ -0,0 +1,36 @@
+#include "PoseStage.h"
+#include "WorkerPool.h"
+
+#include <chrono>
+
+PoseStage::PoseStage() : parallel(true), time(0.0) {}
+
+void PoseStage::run(const std::vector<Shape*>& shapes, double deltaTime) {
+    auto start = std::chrono::steady_clock::now();
+
+    characters.clear();
+    for (Shape* shape : shapes) {
+        if (ImportCharacter* character = dynamic_cast<ImportCharacter*>(shape)) characters.push_back(character);
+    }
+
+    // Each character touches only its own skeleton, clip and player
+    auto updateRange = [this, deltaTime](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) characters[i]->updatePose(deltaTime);
+    };
+
+    if (parallel) {
+        WorkerPool::getInstance().parallelFor(characters.size(), CHARACTERS_PER_CHUNK, updateRange);
+    } else {
+        updateRange(0, characters.size());
+    }
+
+    time = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Getter and setter for parallel evaluation
+bool PoseStage::isParallel() const { return parallel; }
+void PoseStage::setParallel(bool parallel) { this->parallel = parallel; }
+
+// Getters for the last run
+size_t PoseStage::getCharacterCount() const { return characters.size(); }
+double PoseStage::getTime() const { return time; }
@@ -1,6 +1,8 @@
 #include "Application.h"
 #include "Renderer.h"
 
+#include "WorkerPool.h"
+
 #include "glad/glad.h"
 #include <GLFW/glfw3.h>
 
@@ -34,6 +36,30 @@ void Renderer::setShaderProgram(GLuint shaderProg) {
 }
 
 
+// Getter for Skinning Shader Program
+GLuint Renderer::getSkinningShaderProgram() const {
+    return skinningShaderProgram;
+}
+
+
+// Setter for Skinning Shader Program
+void Renderer::setSkinningShaderProgram(GLuint shaderProg) {
+    skinningShaderProgram = shaderProg;
+    if (skinningShaderProgram == 0) return;
+
+    // Point the palette blocks at the bindings ImportCharacter uploads to
+    GLuint paletteBlock = glGetUniformBlockIndex(skinningShaderProgram, "JointPalette");
+    if (paletteBlock != GL_INVALID_INDEX) {
+        glUniformBlockBinding(skinningShaderProgram, paletteBlock, ImportCharacter::JOINT_PALETTE_BINDING);
+    }
+
+    GLuint dualQuaternionBlock = glGetUniformBlockIndex(skinningShaderProgram, "JointDualQuaternions");
+    if (dualQuaternionBlock != GL_INVALID_INDEX) {
+        glUniformBlockBinding(skinningShaderProgram, dualQuaternionBlock, ImportCharacter::DUAL_QUATERNION_PALETTE_BINDING);
+    }
+}
+
+
 void Renderer::updateCameraPosition() {
 
     // Convert spherical coordinates to Cartesian coordinates
@@ -237,11 +263,25 @@ void Renderer::renderScene(ShapeManager& shapeManager) {
 
 	        if (ImGui::MenuItem("Import Character")) {
 	            FileImporter fileImporter;  // This creates an instance of the FileImporter class
+	            fileImporter.setSkinInfluenceLimit(skinInfluenceLimit);
+	            fileImporter.setSkinWeightPrecision(skinWeightPrecision == 0 ? PackedSkinWeights::UNORM8 : PackedSkinWeights::UNORM16);
 	            if (fileImporter.importCharacterFile(shapeManager)) {  // Function to import .obj files
 		        shapeManager.setSelectedShapeByLastAdded();
 		    }
 	        }
 
+	        if (ImGui::MenuItem("Import BVH")) {
+	            FileImporter fileImporter;
+	            if (fileImporter.importBvhFile(shapeManager)) {
+		        shapeManager.setSelectedShapeByLastAdded();
+		    }
+	        }
+
+	        // Skin weight compression for the next character import
+	        ImGui::SliderInt("Max Influences", &skinInfluenceLimit, 1, 8);
+	        const char* precisionModes[] = { "8-bit", "16-bit" };
+	        ImGui::Combo("Weight Precision", &skinWeightPrecision, precisionModes, IM_ARRAYSIZE(precisionModes));
+
 	        ImGui::EndMenu();
             }
 
@@ -485,13 +525,369 @@ void Renderer::renderScene(ShapeManager& shapeManager) {
 				importCharacter->setDisplayMode(static_cast<ImportCharacter::DisplayMode>(currentMode));  // Cast to DisplayMode
 			}
 
+			// Change skinning backend between the scalar loop, the SIMD kernel and the vertex shader
+			const char* backendModes[] = { "CPU Scalar", "CPU SIMD", "GPU" };
+			int currentBackend = importCharacter->getSkinningBackend();
+
+			if (ImGui::Combo("Skinning", &currentBackend, backendModes, IM_ARRAYSIZE(backendModes))) {
+				importCharacter->setSkinningBackend(static_cast<ImportCharacter::SkinningBackend>(currentBackend));
+			}
+			// Change blending between linear blend and dual quaternion skinning
+			const char* methodModes[] = { "Linear Blend", "Dual Quaternion" };
+			int currentMethod = importCharacter->getSkinningMethod();
+
+			if (ImGui::Combo("Blending", &currentMethod, methodModes, IM_ARRAYSIZE(methodModes))) {
+				importCharacter->setSkinningMethod(static_cast<ImportCharacter::SkinningMethod>(currentMethod));
+			}
+
+			if (currentBackend == ImportCharacter::CPU_SIMD) {
+				ImGui::Text("SIMD instruction set: %s", SkinningKernel::getInstructionSetName(importCharacter->getSkinningKernel().getInstructionSet()));
+			}
+			if (currentBackend == ImportCharacter::GPU && !importCharacter->isGPUSkinningAvailable()) {
+				ImGui::Text("GPU skinning unavailable, using CPU Scalar");
+			}
+			if (currentBackend != ImportCharacter::GPU || !importCharacter->isGPUSkinningAvailable()) {
+				ImGui::Text("Last re-skin: %zu / %zu vertices, %zu upload ranges, %.3f ms",
+					importCharacter->getReskinnedVertexCount(), importCharacter->getBindVertices().size(),
+					importCharacter->getUploadRangeCount(), importCharacter->getSkinningTime());
+			}
+
+			// Rigid skinning for distant characters, picked from the projected size unless forced
+			bool automaticLOD = importCharacter->isAutomaticLOD();
+			if (ImGui::Checkbox("Automatic LOD", &automaticLOD)) {
+				importCharacter->setAutomaticLOD(automaticLOD);
+			}
+			const char* lodModes[] = { "Full", "Rigid" };
+			int currentLOD = importCharacter->getSkinningLOD();
+			if (ImGui::Combo("Skinning LOD", &currentLOD, lodModes, IM_ARRAYSIZE(lodModes))) {
+				importCharacter->setSkinningLOD(static_cast<ImportCharacter::SkinningLOD>(currentLOD));
+			}
+			ImGui::Text("Projected size: %.0f px", importCharacter->getProjectedSize());
+
+			const PackedSkinWeights& packedAttachments = importCharacter->getPackedAttachments();
+			if (!packedAttachments.isEmpty()) {
+				ImGui::Text("Skin weights: %d influences, %d-bit, %zu bytes per vertex",
+					packedAttachments.getMaxInfluences(), static_cast<int>(packedAttachments.getPrecision()),
+					packedAttachments.getBytesPerVertex());
+			}
+
+			// Characters imported from the same files share the mesh, weights and static buffers
+			const std::shared_ptr<const CharacterAsset>& asset = importCharacter->getAsset();
+			ImGui::Text("Shared asset: %.1f KB, %ld characters; this one: %.1f KB",
+				asset->getMemoryUsage() / 1024.0, asset.use_count(), importCharacter->getInstanceMemoryUsage() / 1024.0);
+
+			// Record poses into a vertex cache file, or play one back without FK and skinning
+			const char* cachePatterns[] = { "*.vcache" };
+			if (importCharacter->isRecordingCache()) {
+				ImGui::Text("Recording vertex cache: %zu frames", importCharacter->getRecordedFrameCount());
+				if (ImGui::Button("Stop Recording")) {
+					importCharacter->stopCacheRecording();
+				}
+			} else if (importCharacter->isPlayingCache()) {
+				int cacheFrame = static_cast<int>(importCharacter->getCacheFrame());
+				if (ImGui::SliderInt("Cache Frame", &cacheFrame, 0, static_cast<int>(importCharacter->getCacheFrameCount()) - 1)) {
+					importCharacter->setCacheFrame(static_cast<size_t>(cacheFrame));
+				}
+				bool cacheRunning = importCharacter->isCachePlaybackRunning();
+				if (ImGui::Checkbox("Play Cache", &cacheRunning)) {
+					importCharacter->setCachePlaybackRunning(cacheRunning);
+				}
+				if (ImGui::Button("Close Cache")) {
+					importCharacter->closeCachePlayback();
+				}
+			} else {
+				if (ImGui::Button("Record Cache...")) {
+					const char* path = tinyfd_saveFileDialog("Record Vertex Cache", "poses.vcache", 1, cachePatterns, "Vertex cache files");
+					if (path && !importCharacter->startCacheRecording(path)) {
+						std::cerr << "Unable to create vertex cache: " << path << std::endl;
+					}
+				}
+				ImGui::SameLine();
+				if (ImGui::Button("Play Cache...")) {
+					const char* path = tinyfd_openFileDialog("Play Vertex Cache", "", 1, cachePatterns, "Vertex cache files", 0);
+					if (path && !importCharacter->openCachePlayback(path)) {
+						std::cerr << "Unable to open vertex cache for this character: " << path << std::endl;
+					}
+				}
+			}
+
+			// Keyframe animation: key the current slider pose, then play it back
+			AnimationClip& clip = importCharacter->getAnimationClip();
+			CompressedClip& compressedClip = importCharacter->getCompressedClip();
+			AnimationPlayer& player = importCharacter->getAnimationPlayer();
+			ImGui::Text("Animation clip: %zu keyframes, %.2f s", clip.getKeyframeTimes().size(), clip.getDuration());
+			ImGui::DragFloat("Key Time", &keyframeTime, 0.05f, 0.0f, 600.0f, "%.2f s");
+			bool clipEdited = false;
+			if (ImGui::Button("Add Keyframe")) {
+				clip.addKeyframe(keyframeTime, importCharacter->getSkeletalModel());
+				keyframeTime += 1.0f;
+				clipEdited = true;
+			}
+			ImGui::SameLine();
+			if (ImGui::Button("Clear Clip")) {
+				player.setPlaying(false);
+				clip.clear();
+				keyframeTime = 0.0f;
+				clipEdited = true;
+			}
+
+			// A compressed copy no longer matches an edited clip
+			if (clipEdited) {
+				player.setCompressedClip(nullptr);
+				compressedClip.clear();
+				importCharacter->markClipChanged();
+			}
+
+			// Long takes stream from disk; only the chunks around the playhead are resident
+			AnimationStream& stream = importCharacter->getAnimationStream();
+			const char* streamPatterns[] = { "*.hmstream" };
+			if (stream.isOpen()) {
+				ImGui::Text("Stream: %zu frames, %.2f s, %.1f MB on disk, %.1f MB resident",
+					stream.getFrameCount(), stream.getDuration(),
+					stream.getFileSize() / (1024.0f * 1024.0f), stream.getResidentSize() / (1024.0f * 1024.0f));
+				if (ImGui::Button("Close Stream")) {
+					importCharacter->closeAnimationStream();
+				}
+			} else {
+				if (!clip.isEmpty() && ImGui::Button("Export Stream...")) {
+					const char* path = tinyfd_saveFileDialog("Export Animation Stream", "take.hmstream", 1, streamPatterns, "Animation streams");
+					if (path && !importCharacter->exportAnimationStream(path)) {
+						std::cerr << "Unable to write animation stream: " << path << std::endl;
+					}
+				}
+				if (!clip.isEmpty()) ImGui::SameLine();
+				if (ImGui::Button("Open Stream...")) {
+					const char* path = tinyfd_openFileDialog("Open Animation Stream", "", 1, streamPatterns, "Animation streams", 0);
+					if (path && !importCharacter->openAnimationStream(path)) {
+						std::cerr << "Unable to open animation stream for this character: " << path << std::endl;
+					}
+				}
+			}
+
+			if (!clip.isEmpty() || stream.isOpen()) {
+				bool playing = player.isPlaying();
+				if (ImGui::Checkbox("Play", &playing)) {
+					player.setPlaying(playing);
+				}
+				ImGui::SameLine();
+				bool looping = player.isLooping();
+				if (ImGui::Checkbox("Loop", &looping)) {
+					player.setLooping(looping);
+				}
+				float speed = player.getSpeed();
+				if (ImGui::SliderFloat("Speed", &speed, 0.0f, 4.0f, "%.2fx")) {
+					player.setSpeed(speed);
+				}
+				float clipTime = player.getTime();
+				float duration = stream.isOpen() ? stream.getDuration() : clip.getDuration();
+				if (ImGui::SliderFloat("Clip Time", &clipTime, 0.0f, duration, "%.2f s")) {
+					player.setTime(clipTime);
+				}
+			}
+			if (!clip.isEmpty()) {
+				// Compress with a world-space error tolerance and report what it cost
+				ImGui::SliderFloat("Tolerance", &clipTolerance, 0.0001f, 0.05f, "%.4f", ImGuiSliderFlags_Logarithmic);
+				if (ImGui::Button("Compress Clip")) {
+					compressedClip.compress(clip, importCharacter->getSkeletalModel(), clipTolerance);
+					clipCompressionError = CompressedClip::measureError(clip, compressedClip, importCharacter->getSkeletalModel());
+					if (player.getCompressedClip()) player.setCompressedClip(&compressedClip);
+				}
+				if (!compressedClip.isEmpty()) {
+					ImGui::Text("Compressed: %zu -> %zu keys, %zu -> %zu bytes (%.1f:1), max error %.5f",
+						compressedClip.getSourceKeyCount(), compressedClip.getKeyCount(),
+						compressedClip.getSourceSize(), compressedClip.getCompressedSize(),
+						static_cast<float>(compressedClip.getSourceSize()) / compressedClip.getCompressedSize(),
+						clipCompressionError);
+					bool playCompressed = player.getCompressedClip() != nullptr;
+					if (ImGui::Checkbox("Play Compressed", &playCompressed)) {
+						player.setCompressedClip(playCompressed ? &compressedClip : nullptr);
+					}
+				}
+			}
+
+			// Pose layers: upper body blended toward the clip at an offset, plus an additive layer
+			if (!clip.isEmpty()) {
+				bool poseLayering = importCharacter->isPoseLayering();
+				if (ImGui::Checkbox("Pose Layers", &poseLayering)) {
+					importCharacter->setPoseLayering(poseLayering);
+				}
+				if (poseLayering) {
+					int upperBodyJoint = importCharacter->getUpperBodyJoint();
+					int layerJointCount = static_cast<int>(importCharacter->getSkeletalModel().getJoints().size());
+					if (ImGui::SliderInt("Upper Body Joint", &upperBodyJoint, 0, std::max(0, layerJointCount - 1))) {
+						importCharacter->setUpperBodyJoint(upperBodyJoint);
+					}
+					float upperBodyWeight = importCharacter->getUpperBodyWeight();
+					if (ImGui::SliderFloat("Upper Body Weight", &upperBodyWeight, 0.0f, 1.0f)) {
+						importCharacter->setUpperBodyWeight(upperBodyWeight);
+					}
+					float upperBodyOffset = importCharacter->getUpperBodyOffset();
+					if (ImGui::SliderFloat("Upper Body Offset", &upperBodyOffset, 0.0f, clip.getDuration(), "%.2f s")) {
+						importCharacter->setUpperBodyOffset(upperBodyOffset);
+					}
+					float additiveWeight = importCharacter->getAdditiveWeight();
+					if (ImGui::SliderFloat("Additive Weight", &additiveWeight, 0.0f, 1.0f)) {
+						importCharacter->setAdditiveWeight(additiveWeight);
+					}
+					float additiveTime = importCharacter->getAdditiveTime();
+					if (ImGui::SliderFloat("Additive Pose Time", &additiveTime, 0.0f, clip.getDuration(), "%.2f s")) {
+						importCharacter->setAdditiveTime(additiveTime);
+					}
+					ImGui::Text("Pose layers: %zu nodes, %.3f ms", importCharacter->getBlendTree().getNodeCount(),
+						importCharacter->getBlendTime());
+				}
+			}
+
+			// IK: pin an end joint to a target, solving the bones above it
+			std::vector<IKChain>& ikChains = importCharacter->getIKChains();
+			SkeletalModel& skeletalModel = importCharacter->getSkeletalModel();
+			int jointCount = static_cast<int>(skeletalModel.getJoints().size());
+			ImGui::SliderInt("IK End Joint", &ikEndJoint, 0, std::max(0, jointCount - 1));
+			ImGui::SliderInt("IK Bones", &ikBoneCount, 1, 8);
+			const char* ikMethods[] = { "CCD", "FABRIK" };
+			ImGui::Combo("IK Method", &ikMethod, ikMethods, IM_ARRAYSIZE(ikMethods));
+			if (ImGui::Button("Add IK Chain")) {
+				IKChain chain;
+				if (chain.setJoints(skeletalModel, ikEndJoint, ikBoneCount)) {
+					skeletalModel.updateCurrentJointToWorldTransforms();
+					chain.setTarget(glm::vec3(skeletalModel.getJointToWorldTransform(ikEndJoint)[3]));
+					chain.setMethod(static_cast<IKChain::Method>(ikMethod));
+					ikChains.push_back(chain);
+				} else {
+					std::cerr << "Joint " << ikEndJoint << " has fewer than " << ikBoneCount << " bones above it" << std::endl;
+				}
+			}
+			if (!ikChains.empty()) {
+				ImGui::SliderInt("IK Iterations", &ikMaxIterations, 1, 64);
+				ImGui::SliderFloat("IK Tolerance", &ikTolerance, 0.0001f, 0.05f, "%.4f", ImGuiSliderFlags_Logarithmic);
+
+				float worstError = 0.0f;
+				for (size_t c = 0; c < ikChains.size(); ++c) {
+					IKChain& chain = ikChains[c];
+					chain.setMaxIterations(ikMaxIterations);
+					chain.setTolerance(ikTolerance);
+					worstError = std::max(worstError, chain.getError());
+
+					ImGui::PushID(static_cast<int>(c));
+					glm::vec3 target = chain.getTarget();
+					ImGui::Text("Chain %zu: joint %d, %d bones, %s", c, chain.getEndJoint(), chain.getBoneCount(),
+						ikMethods[chain.getMethod()]);
+					if (ImGui::DragFloat3("Target", &target[0], 0.01f)) {
+						chain.setTarget(target);
+					}
+					ImGui::SameLine();
+					bool removed = ImGui::Button("Remove");
+					ImGui::PopID();
+					if (removed) {
+						ikChains.erase(ikChains.begin() + c);
+						break;
+					}
+				}
+				ImGui::Text("IK: %zu chains, %.3f ms, max error %.4f", ikChains.size(), importCharacter->getIKSolveTime(), worstError);
+			}
+
+			// Jiggle bones: the joint follows a spring-driven particle by turning its parent
+			JiggleBones& jiggleBones = importCharacter->getJiggleBones();
+			ImGui::SliderInt("Jiggle Joint", &jiggleJoint, 0, std::max(0, jointCount - 1));
+			ImGui::SameLine();
+			if (ImGui::Button("Add Jiggle")) {
+				skeletalModel.updateCurrentJointToWorldTransforms();
+				if (!jiggleBones.addJoint(skeletalModel, jiggleJoint)) {
+					std::cerr << "Joint " << jiggleJoint << " has no parent, or it or a sibling already jiggles" << std::endl;
+				}
+			}
+			if (!jiggleBones.isEmpty()) {
+				glm::vec3 gravity = jiggleBones.getGravity();
+				if (ImGui::DragFloat3("Jiggle Gravity", &gravity[0], 0.1f)) {
+					jiggleBones.setGravity(gravity);
+				}
+
+				// Own ID scope, so the widgets do not clash with the IK chains'
+				const std::vector<int>& jiggleJoints = jiggleBones.getJoints();
+				ImGui::PushID("Jiggle");
+				for (size_t j = 0; j < jiggleJoints.size(); ++j) {
+					ImGui::PushID(static_cast<int>(j));
+					ImGui::Text("Jiggle %zu: joint %d", j, jiggleJoints[j]);
+					float stiffness = jiggleBones.getStiffness(j);
+					if (ImGui::SliderFloat("Stiffness", &stiffness, 0.0f, JiggleBones::MAX_STIFFNESS, "%.1f", ImGuiSliderFlags_Logarithmic)) {
+						jiggleBones.setStiffness(j, stiffness);
+					}
+					float damping = jiggleBones.getDamping(j);
+					if (ImGui::SliderFloat("Damping", &damping, 0.0f, 1.0f, "%.3f")) {
+						jiggleBones.setDamping(j, damping);
+					}
+					ImGui::SameLine();
+					bool removed = ImGui::Button("Remove");
+					ImGui::PopID();
+					if (removed) {
+						jiggleBones.removeJoint(skeletalModel, jiggleJoints[j]);
+						break;
+					}
+				}
+				ImGui::PopID();
+				ImGui::Text("Jiggle: %zu joints, %d sub-steps (%s), %.3f ms%s", jiggleJoints.size(), jiggleBones.getSubstepCount(),
+					SkinningKernel::getInstructionSetName(jiggleBones.getInstructionSet()), jiggleBones.getTime(),
+					jiggleBones.isSleeping() ? ", at rest" : "");
+			}
+
+			// Scene-wide pose update across characters
+			bool parallelPoses = poseStage.isParallel();
+			if (ImGui::Checkbox("Parallel Pose Update", &parallelPoses)) {
+				poseStage.setParallel(parallelPoses);
+			}
+			ImGui::Text("Pose update: %zu characters, %.3f ms", poseStage.getCharacterCount(), poseStage.getTime());
+
+			// Instanced crowd of GPU-skinned characters sharing this one's asset
+			bool crowdRendering = crowdRenderer.isEnabled();
+			if (ImGui::Checkbox("Crowd Rendering", &crowdRendering)) {
+				crowdRenderer.setEnabled(crowdRendering);
+			}
+			ImGui::SliderInt("Copies", &crowdCopies, 1, 1000);
+			ImGui::SameLine();
+			if (ImGui::Button("Add Copies")) {
+				// Square grid behind the selected character, one bounding sphere apart
+				float spacing = 2.0f * importCharacter->getAsset()->getBoundsRadius() * importCharacter->getScale();
+				int columns = static_cast<int>(std::ceil(std::sqrt(static_cast<float>(crowdCopies + 1))));
+				float duration = importCharacter->getAnimationClip().getDuration();
+
+				for (int i = 1; i <= crowdCopies; ++i) {
+					ImportCharacter* copy = importCharacter->createInstance(shapeManager.incrementShapeCounter());
+					if (!copy) break;
+					copy->setPosition(importCharacter->getX() + (i % columns) * spacing, importCharacter->getY(),
+					                  importCharacter->getZ() - (i / columns) * spacing);
+					copy->setShapeType(importCharacter->getShapeType());
+					if (duration > 0.0f) copy->getAnimationPlayer().setTime(std::fmod(i * 0.37f, duration)); // Out of step
+					shapeManager.addShape(copy);
+				}
+			}
+			if (crowdRenderer.isEnabled()) {
+				ImGui::Text("Crowd: %zu instances, %zu draw calls, %.1f KB uploaded, %.3f ms",
+					crowdRenderer.getInstanceCount(), crowdRenderer.getDrawCallCount(),
+					crowdRenderer.getUploadSize() / 1024.0, crowdRenderer.getTime());
+			}
+
+			// Multithreaded skinning across vertex ranges
+			bool parallelSkinning = importCharacter->isParallelSkinning();
+			if (ImGui::Checkbox("Parallel Skinning", &parallelSkinning)) {
+				importCharacter->setParallelSkinning(parallelSkinning);
+			}
+			if (parallelSkinning) {
+				int skinningThreads = WorkerPool::getInstance().getThreadCount();
+				if (ImGui::SliderInt("Threads", &skinningThreads, 1, 64)) {
+					WorkerPool::getInstance().setThreadCount(skinningThreads);
+				}
+			}
+
             ImGui::Separator();
             ImGui::Text("Joint Rotations (x, y, z)");
+			ImGui::Text("Last FK update: %zu / %zu joints",
+				importCharacter->getSkeletalModel().getUpdatedJointCount(),
+				importCharacter->getSkeletalModel().getJoints().size());
 
 			// Get references to vertices and bindVertices
 			std::vector<glm::vec3>& currentVertices = importCharacter->getVertices();  // Direct access to vertices from Shape
 			const std::vector<glm::vec3>& bindVertices = importCharacter->getBindVertices();
-			const std::vector<std::vector<float>>& attachments = importCharacter->getAttachments();
+			const SkinWeights& attachments = importCharacter->getAttachments();
 
 
 
@@ -501,8 +897,10 @@ void Renderer::renderScene(ShapeManager& shapeManager) {
 			// ImGui control to apply joint transformations and trigger the mesh update
 			for (size_t i = 0; i < importCharacter->getSkeletalModel().getJoints().size(); ++i) {
 
-				// Retrieve stored rotation as a mutable array
-				glm::vec3 jointRotationVec = importCharacter->getSkeletalModel().getJoints()[i]->getRotation();
+				// Retrieve stored rotation as a mutable array; a playing clip, IK and jiggle bones pose joints by quaternion
+				glm::vec3 jointRotationVec = importCharacter->getAnimationPlayer().isPlaying() || !ikChains.empty() || !jiggleBones.isEmpty()
+					? SkeletalModel::quaternionToEuler(importCharacter->getSkeletalModel().getJointRotation(i))
+					: importCharacter->getSkeletalModel().getJoints()[i]->getRotation();
 				float jointRotation[3] = { jointRotationVec.x, jointRotationVec.y, jointRotationVec.z };
 
 				// ImGui sliders for joint rotation control with 1 degree per unit
@@ -610,6 +1008,14 @@ void Renderer::renderScene(ShapeManager& shapeManager) {
     // Clear the screen
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
+    // The skinning program shares the camera and lights
+    if (skinningShaderProgram != 0) {
+        glUseProgram(skinningShaderProgram);
+        glUniformMatrix4fv(glGetUniformLocation(skinningShaderProgram, "view"), 1, GL_FALSE, glm::value_ptr(viewMatrix));
+        glUniformMatrix4fv(glGetUniformLocation(skinningShaderProgram, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
+        setupLighting(skinningShaderProgram);
+    }
+
     // Setup lighting
     setupLighting(shaderProgram);
 
@@ -618,8 +1024,23 @@ void Renderer::renderScene(ShapeManager& shapeManager) {
         drawAxis(getShaderProgram());
     }
 
-    // Draw all shapes
+    // Pose every character first; drawing only consumes the results
+    poseStage.run(shapeManager.getShapes(), ImGui::GetIO().DeltaTime);
+
     for (Shape* shape : shapeManager.getShapes()) {
+        if (ImportCharacter* importCharacter = dynamic_cast<ImportCharacter*>(shape)) {
+            importCharacter->setSkinningShaderProgram(skinningShaderProgram);
+            importCharacter->updateSkinningLOD(viewMatrix, projection, height);
+            importCharacter->stepCachePlayback();
+        }
+    }
+
+    // GPU-skinned characters in one instanced draw per asset, then the rest one by one
+    std::vector<Shape*> remainingShapes = crowdRenderer.draw(shapeManager.getShapes(), skinningShaderProgram);
+    glUseProgram(shaderProgram);
+
+    // Draw all shapes
+    for (Shape* shape : remainingShapes) {
         shape->applyTransform(shaderProgram);
         shape->draw(shaderProgram);
     }
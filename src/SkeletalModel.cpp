@@ -1,16 +1,21 @@
 #include "SkeletalModel.h"
 #include <iostream>
 #include <functional>
+#include <cmath>
 
-SkeletalModel::SkeletalModel() {}
+SkeletalModel::SkeletalModel()
+    : m_rootJoint(nullptr), m_poseVersion(1), m_evaluatedPoseVersion(0),
+      m_localTransformsStale(true), m_updatedJointCount(0) {
+    m_worldTransforms.assign(1, glm::mat4(1.0f));
+}
 
 // Getters and setters for root joint
 Joint* SkeletalModel::getRootJoint() const { return m_rootJoint; }
-void SkeletalModel::setRootJoint(Joint* rootJoint) { m_rootJoint = rootJoint; }
+void SkeletalModel::setRootJoint(Joint* rootJoint) { m_rootJoint = rootJoint; updateParentIndices(); markPoseChanged(); }
 
 // Getters and setters for all joints
 const std::vector<Joint*>& SkeletalModel::getJoints() const { return m_joints; }
-void SkeletalModel::setJoints(const std::vector<Joint*>& joints) { m_joints = joints; }
+void SkeletalModel::setJoints(const std::vector<Joint*>& joints) { m_joints = joints; updateParentIndices(); markPoseChanged(); }
 
 // Getter for joint centers and bone pairs
 const std::vector<glm::vec3>& SkeletalModel::getJointCenters() const { return jointCenters; }
@@ -18,6 +23,175 @@ const std::vector<std::pair<glm::vec3, glm::vec3>> SkeletalModel::getBonePairs()
 
 MatrixStack& SkeletalModel::getMatrixStack() { return m_matrixStack; }
 
+// Getter for the skinning palette
+const std::vector<glm::mat4>& SkeletalModel::getSkinningPalette() const { return m_skinningPalette; }
+const std::vector<DualQuaternion>& SkeletalModel::getDualQuaternionPalette() const { return m_dualQuaternionPalette; }
+
+// Getter for the pose version
+unsigned long SkeletalModel::getPoseVersion() const { return m_poseVersion; }
+
+// Getters for the per-joint change versions and parent indices
+const std::vector<unsigned long>& SkeletalModel::getJointChangeVersions() const { return m_jointChangeVersions; }
+const std::vector<int>& SkeletalModel::getParentIndices() const { return m_parentIndices; }
+
+// Getter for the FK update counter
+size_t SkeletalModel::getUpdatedJointCount() const { return m_updatedJointCount; }
+
+size_t SkeletalModel::getMemoryUsage() const {
+    size_t bytes = m_joints.size() * sizeof(Joint);
+    for (const Joint* joint : m_joints) bytes += joint->getChildren().capacity() * sizeof(Joint*);
+
+    return bytes + m_joints.capacity() * sizeof(Joint*) +
+           (jointCenters.capacity() + m_localTranslations.capacity() + m_localScales.capacity()) * sizeof(glm::vec3) +
+           bonePairs.capacity() * sizeof(std::pair<glm::vec3, glm::vec3>) +
+           (m_skinningPalette.capacity() + m_localTransforms.capacity() + m_worldTransforms.capacity() +
+            m_inverseBindTransforms.capacity()) * sizeof(glm::mat4) +
+           m_dualQuaternionPalette.capacity() * sizeof(DualQuaternion) + m_localRotations.capacity() * sizeof(glm::quat) +
+           (m_parentIndices.capacity() + m_flatJoints.capacity() + m_flatParents.capacity() + m_jointSlots.capacity() +
+            m_subtreeSizes.capacity()) * sizeof(int) +
+           m_jointDirty.capacity() + m_jointChangeVersions.capacity() * sizeof(unsigned long);
+}
+
+// Getter for the parent-before-child joint order
+const std::vector<int>& SkeletalModel::getEvaluationOrder() const { return m_flatJoints; }
+
+// Getter for a joint's world transform
+const glm::mat4& SkeletalModel::getJointToWorldTransform(int jointIndex) const {
+    return m_worldTransforms[m_jointSlots[jointIndex]];
+}
+
+// Every joint counts as changed
+void SkeletalModel::markPoseChanged() {
+    ++m_poseVersion;
+    m_jointDirty.assign(m_joints.size(), 1);
+    m_localTransformsStale = true;
+}
+
+void SkeletalModel::markJointChanged(int jointIndex) {
+    ++m_poseVersion;
+    m_jointDirty.resize(m_joints.size(), 1);
+    m_jointDirty[jointIndex] = 1;
+}
+
+void SkeletalModel::updateParentIndices() {
+    std::unordered_map<const Joint*, int> jointIndices;
+    for (size_t i = 0; i < m_joints.size(); ++i) {
+        jointIndices[m_joints[i]] = static_cast<int>(i);
+    }
+
+    m_parentIndices.assign(m_joints.size(), -1);
+    for (size_t i = 0; i < m_joints.size(); ++i) {
+        for (const Joint* child : m_joints[i]->getChildren()) {
+            auto it = jointIndices.find(child);
+            if (it != jointIndices.end()) m_parentIndices[it->second] = static_cast<int>(i);
+        }
+    }
+
+    buildFlatSkeleton();
+}
+
+void SkeletalModel::buildFlatSkeleton() {
+
+    // Depth-first order keeps every parent before its children and each
+    // subtree in one contiguous run of slots
+    size_t jointCount = m_joints.size();
+    std::vector<std::vector<int>> children(jointCount);
+    std::vector<int> stack;
+
+    for (size_t i = jointCount; i-- > 0;) {
+        if (m_parentIndices[i] >= 0) children[m_parentIndices[i]].push_back(static_cast<int>(i));
+        else stack.push_back(static_cast<int>(i));
+    }
+
+    m_flatJoints.clear();
+    m_jointSlots.assign(jointCount, -1);
+
+    while (!stack.empty()) {
+        int joint = stack.back();
+        stack.pop_back();
+
+        m_jointSlots[joint] = static_cast<int>(m_flatJoints.size());
+        m_flatJoints.push_back(joint);
+
+        // Pushed in reverse so children come out in index order
+        stack.insert(stack.end(), children[joint].begin(), children[joint].end());
+    }
+
+    // Joints in a parent cycle are never reached; treat them as roots
+    for (size_t i = 0; i < jointCount; ++i) {
+        if (m_jointSlots[i] < 0) {
+            m_jointSlots[i] = static_cast<int>(m_flatJoints.size());
+            m_flatJoints.push_back(static_cast<int>(i));
+        }
+    }
+
+    int identitySlot = static_cast<int>(jointCount);
+    m_flatParents.resize(jointCount);
+    for (size_t s = 0; s < jointCount; ++s) {
+        int parent = m_parentIndices[m_flatJoints[s]];
+        m_flatParents[s] = (parent >= 0 && m_jointSlots[parent] < static_cast<int>(s)) ? m_jointSlots[parent] : identitySlot;
+    }
+
+    // Subtree sizes, accumulated from the leaves up
+    m_subtreeSizes.assign(jointCount, 1);
+    for (size_t s = jointCount; s-- > 0;) {
+        if (m_flatParents[s] != identitySlot) m_subtreeSizes[m_flatParents[s]] += m_subtreeSizes[s];
+    }
+
+    m_localTranslations.assign(jointCount, glm::vec3(0.0f));
+    m_localRotations.assign(jointCount, glm::quat(1.0f, 0.0f, 0.0f, 0.0f));
+    m_localScales.assign(jointCount, glm::vec3(1.0f));
+    m_localTransforms.assign(jointCount, glm::mat4(1.0f));
+    m_worldTransforms.assign(jointCount + 1, glm::mat4(1.0f));
+    m_inverseBindTransforms.resize(jointCount, glm::mat4(1.0f));
+    m_jointDirty.assign(jointCount, 1);
+    m_localTransformsStale = true;
+}
+
+void SkeletalModel::gatherLocalTransforms() {
+
+    // Only joints whose matrix no longer matches the one written back were
+    // edited directly; decomposing the others again would add drift
+    for (size_t s = 0; s < m_flatJoints.size(); ++s) {
+        glm::mat4 transform = m_joints[m_flatJoints[s]]->getTransform();
+        if (transform == m_localTransforms[s]) continue;
+
+        glm::vec3 scale(glm::length(glm::vec3(transform[0])),
+                        glm::length(glm::vec3(transform[1])),
+                        glm::length(glm::vec3(transform[2])));
+        glm::mat3 rotation(glm::vec3(transform[0]) / scale.x,
+                           glm::vec3(transform[1]) / scale.y,
+                           glm::vec3(transform[2]) / scale.z);
+
+        m_localTranslations[s] = glm::vec3(transform[3]);
+        m_localRotations[s] = glm::normalize(glm::quat_cast(rotation));
+        m_localScales[s] = scale;
+        m_localTransforms[s] = transform;
+    }
+    m_localTransformsStale = false;
+}
+
+void SkeletalModel::forwardKinematics(size_t beginSlot, size_t endSlot) {
+
+    // Parents come first, so one pass sees every parent's final transform
+    const int* parents = m_flatParents.data();
+    glm::mat4* locals = m_localTransforms.data();
+    glm::mat4* worlds = m_worldTransforms.data();
+
+    for (size_t s = beginSlot; s < endSlot; ++s) {
+        glm::mat3 rotation = glm::mat3_cast(m_localRotations[s]);
+        const glm::vec3& scale = m_localScales[s];
+
+        glm::mat4& local = locals[s];
+        local[0] = glm::vec4(rotation[0] * scale.x, 0.0f);
+        local[1] = glm::vec4(rotation[1] * scale.y, 0.0f);
+        local[2] = glm::vec4(rotation[2] * scale.z, 0.0f);
+        local[3] = glm::vec4(m_localTranslations[s], 1.0f);
+
+        worlds[s] = worlds[parents[s]] * local;
+    }
+}
+
 void SkeletalModel::addJointChild(int parentIndex, Joint* child) {
     if (parentIndex < 0 || parentIndex >= static_cast<int>(m_joints.size())) {
         std::cerr << "Error: Invalid parent index provided." << std::endl;
@@ -27,6 +201,8 @@ void SkeletalModel::addJointChild(int parentIndex, Joint* child) {
     Joint* parent = m_joints[parentIndex];
     parent->addChild(child);
     m_joints.push_back(child);
+    updateParentIndices();
+    markPoseChanged();
 }
 
 void SkeletalModel::setJointTransform(int jointIndex, float rX, float rY, float rZ) {
@@ -43,51 +219,96 @@ void SkeletalModel::setJointTransform(int jointIndex, float rX, float rY, float
         return;
     }
 
-    Joint* joint = m_joints[jointIndex];
+    // Children may have been attached after setJoints()
+    if (m_jointSlots.size() != m_joints.size()) updateParentIndices();
+    if (m_localTransformsStale) gatherLocalTransforms();
 
-    // Set rotation angles (as Euler angles)
-    glm::vec3 rotation(rX, rY, rZ);
-    joint->setRotation(rotation);
+    // Keep the Euler angles for the UI
+    m_joints[jointIndex]->setRotation(glm::vec3(rX, rY, rZ));
 
-    // Convert degrees to radians
-    float radX = glm::radians(rX);
-    float radY = glm::radians(rY);
-    float radZ = glm::radians(rZ);
+    m_localRotations[m_jointSlots[jointIndex]] = eulerToQuaternion(rX, rY, rZ);
+    markJointChanged(jointIndex);
+}
 
-    // Build local transform from translation and rotation
-    glm::mat4 rotationMat = glm::rotate(glm::mat4(1.0f), radX, glm::vec3(1, 0, 0));
-    rotationMat = glm::rotate(rotationMat, radY, glm::vec3(0, 1, 0));
-    rotationMat = glm::rotate(rotationMat, radZ, glm::vec3(0, 0, 1));
 
-    glm::vec3 translation = glm::vec3(joint->getTransform()[3]);
-    glm::mat4 localTransform = glm::translate(glm::mat4(1.0f), translation);
-    localTransform *= rotationMat;
 
-    joint->setTransform(localTransform);
+
+glm::quat SkeletalModel::eulerToQuaternion(float rX, float rY, float rZ) {
+
+    // Product of the X, Y and Z axis rotations, expanded
+    float cx = std::cos(glm::radians(rX) * 0.5f), sx = std::sin(glm::radians(rX) * 0.5f);
+    float cy = std::cos(glm::radians(rY) * 0.5f), sy = std::sin(glm::radians(rY) * 0.5f);
+    float cz = std::cos(glm::radians(rZ) * 0.5f), sz = std::sin(glm::radians(rZ) * 0.5f);
+
+    return glm::quat(cx * cy * cz - sx * sy * sz,
+                     sx * cy * cz + cx * sy * sz,
+                     cx * sy * cz - sx * cy * sz,
+                     sx * sy * cz + cx * cy * sz);
 }
 
+glm::vec3 SkeletalModel::quaternionToEuler(const glm::quat& rotation) {
 
+    // Rx * Ry * Rz has sin(y) in row 0 of column 2
+    glm::mat3 m = glm::mat3_cast(rotation);
+    float y = std::asin(glm::clamp(m[2][0], -1.0f, 1.0f));
+    float x = std::atan2(-m[2][1], m[2][2]);
+    float z = std::atan2(-m[1][0], m[0][0]);
 
+    return glm::degrees(glm::vec3(x, y, z));
+}
 
-void SkeletalModel::bindWorldToJointTransformRecursive(Joint* joint, MatrixStack& myStack) {
+glm::quat SkeletalModel::getJointRotation(int jointIndex) const {
+    // Before the first evaluation the Joint matrix is the only copy
+    if (m_localTransformsStale || m_jointSlots.size() != m_joints.size()) {
+        return glm::quat_cast(glm::mat3(m_joints[jointIndex]->getTransform()));
+    }
+    return m_localRotations[m_jointSlots[jointIndex]];
+}
 
-    // 4.4.1.1. Recursive function for computeBindWorldToJointTransforms()
-    //
-    //
-    // Push the full local bind transform
-    myStack.push(joint->getTransform());
+void SkeletalModel::setJointRotation(int jointIndex, const glm::quat& rotation) {
+    if (jointIndex < 0 || jointIndex >= static_cast<int>(m_joints.size())) return;
+
+    if (m_jointSlots.size() != m_joints.size()) updateParentIndices();
+    if (m_localTransformsStale) gatherLocalTransforms();
+
+    m_localRotations[m_jointSlots[jointIndex]] = rotation;
+    markJointChanged(jointIndex);
+}
 
-    // Compute and store the inverse world-to-joint transform in bind pose
-    glm::mat4 jointToWorld = myStack.top();
-    glm::mat4 worldToJoint = glm::inverse(jointToWorld);
-    joint->setBindWorldToJointTransform(worldToJoint);
+glm::vec3 SkeletalModel::getJointTranslation(int jointIndex) const {
+    if (m_localTransformsStale || m_jointSlots.size() != m_joints.size()) {
+        return glm::vec3(m_joints[jointIndex]->getTransform()[3]);
+    }
+    return m_localTranslations[m_jointSlots[jointIndex]];
+}
+
+void SkeletalModel::setJointTranslation(int jointIndex, const glm::vec3& translation) {
+    if (jointIndex < 0 || jointIndex >= static_cast<int>(m_joints.size())) return;
+
+    if (m_jointSlots.size() != m_joints.size()) updateParentIndices();
+    if (m_localTransformsStale) gatherLocalTransforms();
+
+    m_localTranslations[m_jointSlots[jointIndex]] = translation;
+    markJointChanged(jointIndex);
+}
 
-    for (Joint* child : joint->getChildren()) {
-        bindWorldToJointTransformRecursive(child, myStack);
+glm::vec3 SkeletalModel::getJointScale(int jointIndex) const {
+    if (m_localTransformsStale || m_jointSlots.size() != m_joints.size()) {
+        glm::mat4 transform = m_joints[jointIndex]->getTransform();
+        return glm::vec3(glm::length(glm::vec3(transform[0])), glm::length(glm::vec3(transform[1])),
+                         glm::length(glm::vec3(transform[2])));
     }
+    return m_localScales[m_jointSlots[jointIndex]];
+}
+
+void SkeletalModel::setJointScale(int jointIndex, const glm::vec3& scale) {
+    if (jointIndex < 0 || jointIndex >= static_cast<int>(m_joints.size())) return;
 
-    myStack.pop();
+    if (m_jointSlots.size() != m_joints.size()) updateParentIndices();
+    if (m_localTransformsStale) gatherLocalTransforms();
 
+    m_localScales[m_jointSlots[jointIndex]] = scale;
+    markJointChanged(jointIndex);
 }
 
 void SkeletalModel::computeBindWorldToJointTransforms() {
@@ -106,31 +327,19 @@ void SkeletalModel::computeBindWorldToJointTransforms() {
         return;
     }
 
-    m_matrixStack.clear();
-    m_matrixStack.push(glm::mat4(1.0f));
-
-    bindWorldToJointTransformRecursive(m_rootJoint, m_matrixStack);
+    // Children may have been attached after setJoints()
+    if (m_parentIndices.size() != m_joints.size()) updateParentIndices();
 
+    gatherLocalTransforms();
+    forwardKinematics(0, m_flatJoints.size());
 
-}
-
-void SkeletalModel::currentJointToWorldTransformsRecursive(Joint* joint, MatrixStack& myStack) {
-
-    // 4.4.1.2. Recursive function for updateCurrentJointToWorldTransforms()
-    //
-    //
-     // Push the current joint’s local transform (setJointTransform must have set this)
-     myStack.push(joint->getTransform());
-
-    glm::mat4 jointToWorld = myStack.top();
-    joint->setCurrentJointToWorldTransform(jointToWorld);
-
-    for (Joint* child : joint->getChildren()) {
-        currentJointToWorldTransformsRecursive(child, myStack);
+    for (size_t s = 0; s < m_flatJoints.size(); ++s) {
+        m_inverseBindTransforms[s] = glm::inverse(m_worldTransforms[s]);
+        m_joints[m_flatJoints[s]]->setBindWorldToJointTransform(m_inverseBindTransforms[s]);
     }
 
-    myStack.pop();
-    
+    // The palette depends on the bind pose too
+    markPoseChanged();
 
 }
 
@@ -151,10 +360,67 @@ void SkeletalModel::updateCurrentJointToWorldTransforms() {
         return;
     }
 
-    m_matrixStack.clear();
-    currentJointToWorldTransformsRecursive(m_rootJoint, m_matrixStack);
+    // Nothing moved since the last evaluation
+    if (m_evaluatedPoseVersion == m_poseVersion) return;
+
+    if (m_parentIndices.size() != m_joints.size()) updateParentIndices();
+    // Joints may have been edited directly, so every joint counts as changed
+    if (m_localTransformsStale) {
+        gatherLocalTransforms();
+        m_jointDirty.assign(m_joints.size(), 1);
+    }
+
+    m_jointDirty.resize(m_joints.size(), 1);
+    m_jointChangeVersions.resize(m_joints.size(), 0);
+    m_skinningPalette.resize(m_joints.size());
+    m_dualQuaternionPalette.resize(m_joints.size());
+
+    // A dirty joint moves its whole subtree, which is a contiguous run of
+    // slots; recompute that run and skip past it
+    m_updatedJointCount = 0;
+    size_t count = m_flatJoints.size();
+
+    for (size_t s = 0; s < count;) {
+        if (!m_jointDirty[m_flatJoints[s]]) {
+            ++s;
+            continue;
+        }
+
+        size_t end = s + m_subtreeSizes[s];
+        forwardKinematics(s, end);
+        updateSkinningPalette(s, end);
 
+        for (size_t t = s; t < end; ++t) m_jointChangeVersions[m_flatJoints[t]] = m_poseVersion;
 
+        m_updatedJointCount += end - s;
+        s = end;
+    }
+
+    m_jointDirty.assign(m_joints.size(), 0);
+    m_evaluatedPoseVersion = m_poseVersion;
+
+}
+
+void SkeletalModel::updateSkinningPalette() {
+    m_skinningPalette.resize(m_joints.size());
+    m_dualQuaternionPalette.resize(m_joints.size());
+    updateSkinningPalette(0, m_flatJoints.size());
 }
 
+void SkeletalModel::updateSkinningPalette(size_t beginSlot, size_t endSlot) {
 
+    // Combine the bind world --> joint and current joint --> world transforms
+    // once per pose, so skinning only needs one matrix per joint.
+
+    for (size_t s = beginSlot; s < endSlot; ++s) {
+        int i = m_flatJoints[s];
+        m_skinningPalette[i] = m_worldTransforms[s] * m_inverseBindTransforms[s];
+
+        // Joints only rotate and translate, so every palette entry is rigid
+        m_dualQuaternionPalette[i] = DualQuaternion::fromMatrix(m_skinningPalette[i]);
+
+        // Keep the Joint objects in sync for callers that read them
+        m_joints[i]->setTransform(m_localTransforms[s]);
+        m_joints[i]->setCurrentJointToWorldTransform(m_worldTransforms[s]);
+    }
+}
@@ -0,0 +1,132 @@
+#include "SkinWeights.h"
+
+SkinWeights::SkinWeights() : maxInfluencesPerVertex(0) {
+    offsets.push_back(0);
+    jointOffsets.push_back(0);
+}
+
+void SkinWeights::setFromDense(const std::vector<std::vector<float>>& attachments) {
+    clear();
+
+    // Count the non-zero weights first so the pair array is allocated once
+    size_t nonZero = 0;
+    for (const auto& row : attachments) {
+        for (float weight : row) {
+            if (weight != 0.0f) ++nonZero;
+        }
+    }
+
+    offsets.reserve(attachments.size() + 1);
+    influences.reserve(nonZero);
+
+    for (const auto& row : attachments) {
+        int count = 0;
+        for (size_t j = 0; j < row.size(); ++j) {
+            if (row[j] == 0.0f) continue;
+
+            Influence influence;
+            influence.jointIndex = static_cast<int>(j);
+            influence.weight = row[j];
+            influences.push_back(influence);
+            ++count;
+        }
+
+        offsets.push_back(static_cast<unsigned int>(influences.size()));
+        if (count > maxInfluencesPerVertex) maxInfluencesPerVertex = count;
+    }
+
+    size_t jointCount = 0;
+    for (const auto& row : attachments) {
+        if (row.size() > jointCount) jointCount = row.size();
+    }
+
+    buildJointIndex(jointCount);
+}
+
+void SkinWeights::setFromSparse(const std::vector<unsigned int>& offsets, const std::vector<Influence>& influences, size_t jointCount) {
+    clear();
+
+    this->offsets = offsets;
+    this->influences = influences;
+
+    for (size_t i = 0; i + 1 < offsets.size(); ++i) {
+        int count = static_cast<int>(offsets[i + 1] - offsets[i]);
+        if (count > maxInfluencesPerVertex) maxInfluencesPerVertex = count;
+    }
+
+    for (const Influence& influence : influences) {
+        if (static_cast<size_t>(influence.jointIndex) >= jointCount) jointCount = influence.jointIndex + 1;
+    }
+
+    buildJointIndex(jointCount);
+}
+
+void SkinWeights::buildJointIndex(size_t jointCount) {
+
+    // Transpose into the joint to vertex index with a counting sort
+    jointOffsets.assign(jointCount + 1, 0);
+    for (const Influence& influence : influences) {
+        ++jointOffsets[influence.jointIndex + 1];
+    }
+    for (size_t j = 0; j < jointCount; ++j) {
+        jointOffsets[j + 1] += jointOffsets[j];
+    }
+
+    std::vector<unsigned int> cursor(jointOffsets.begin(), jointOffsets.end() - 1);
+    jointVertices.resize(influences.size());
+    for (size_t i = 0; i + 1 < offsets.size(); ++i) {
+        for (unsigned int k = offsets[i]; k < offsets[i + 1]; ++k) {
+            jointVertices[cursor[influences[k].jointIndex]++] = static_cast<unsigned int>(i);
+        }
+    }
+}
+
+void SkinWeights::clear() {
+    offsets.assign(1, 0);
+    influences.clear();
+    jointOffsets.assign(1, 0);
+    jointVertices.clear();
+    maxInfluencesPerVertex = 0;
+}
+
+const std::vector<unsigned int>& SkinWeights::getOffsets() const { return offsets; }
+const std::vector<SkinWeights::Influence>& SkinWeights::getInfluences() const { return influences; }
+
+const std::vector<unsigned int>& SkinWeights::getJointOffsets() const { return jointOffsets; }
+const std::vector<unsigned int>& SkinWeights::getJointVertices() const { return jointVertices; }
+size_t SkinWeights::getJointCount() const { return jointOffsets.size() - 1; }
+
+size_t SkinWeights::getVertexCount() const { return offsets.size() - 1; }
+size_t SkinWeights::getInfluenceCount() const { return influences.size(); }
+int SkinWeights::getMaxInfluencesPerVertex() const { return maxInfluencesPerVertex; }
+
+int SkinWeights::getLargestInfluences(size_t vertex, int maxCount, Influence* out) const {
+    int count = 0;
+
+    // Insertion sort by descending weight, dropping whatever falls past maxCount
+    for (unsigned int k = offsets[vertex]; k < offsets[vertex + 1]; ++k) {
+        const Influence& influence = influences[k];
+
+        int slot = count;
+        while (slot > 0 && out[slot - 1].weight < influence.weight) {
+            if (slot < maxCount) out[slot] = out[slot - 1];
+            --slot;
+        }
+        if (slot < maxCount) out[slot] = influence;
+        if (count < maxCount) ++count;
+    }
+
+    float total = 0.0f;
+    for (int i = 0; i < count; ++i) total += out[i].weight;
+
+    if (total > 0.0f) {
+        for (int i = 0; i < count; ++i) out[i].weight /= total;
+    }
+
+    return count;
+}
+
+size_t SkinWeights::getMemoryUsage() const {
+    return offsets.capacity() * sizeof(unsigned int) + influences.capacity() * sizeof(Influence) +
+           (jointOffsets.capacity() + jointVertices.capacity()) * sizeof(unsigned int);
+}
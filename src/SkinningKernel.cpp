@@ -0,0 +1,766 @@
+#include "SkinningKernel.h"
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+// The vector paths use GCC/Clang target attributes so the rest of the build
+// does not need -mavx2; the CPU is checked before they are ever called.
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define SKINNING_KERNEL_X86 1
+#include <immintrin.h>
+#else
+#define SKINNING_KERNEL_X86 0
+#endif
+
+constexpr float SkinningKernel::SKINNING_TOLERANCE;
+
+// The dual quaternion paths read the palette as 8 packed floats per joint
+static_assert(sizeof(DualQuaternion) == 8 * sizeof(float), "DualQuaternion must be 8 packed floats");
+
+SkinningKernel::SkinningKernel()
+    : vertexCount(0), blockCount(0), slotCount(0),
+      instructionSet(detectInstructionSet()) {}
+
+void SkinningKernel::setup(const std::vector<glm::vec3>& bindVertices, const std::vector<glm::vec3>& bindNormals,
+                           const SkinWeights& weights) {
+
+    vertexCount = std::min(std::min(bindVertices.size(), bindNormals.size()), weights.getVertexCount());
+    slotCount = weights.getMaxInfluencesPerVertex();
+
+    size_t windowCount = (vertexCount + SORT_WINDOW - 1) / SORT_WINDOW;
+    size_t laneCount = windowCount * SORT_WINDOW;
+    blockCount = laneCount / BLOCK_SIZE;
+
+    const std::vector<unsigned int>& offsets = weights.getOffsets();
+    const std::vector<SkinWeights::Influence>& influences = weights.getInfluences();
+
+    // Order each window by descending influence count; padding lanes sort last
+    laneVertex.resize(laneCount);
+    for (size_t i = 0; i < laneCount; ++i) {
+        laneVertex[i] = static_cast<unsigned int>(std::min(i, vertexCount));
+    }
+
+    auto influenceCount = [&](unsigned int v) {
+        return v < vertexCount ? static_cast<int>(offsets[v + 1] - offsets[v]) : -1;
+    };
+
+    for (size_t w = 0; w < windowCount; ++w) {
+        std::stable_sort(laneVertex.begin() + w * SORT_WINDOW, laneVertex.begin() + (w + 1) * SORT_WINDOW,
+                         [&](unsigned int a, unsigned int b) { return influenceCount(a) > influenceCount(b); });
+    }
+
+    // Structure-of-arrays bind positions and normals, zero for padding lanes
+    bindX.assign(laneCount, 0.0f);
+    bindY.assign(laneCount, 0.0f);
+    bindZ.assign(laneCount, 0.0f);
+    normalX.assign(laneCount, 0.0f);
+    normalY.assign(laneCount, 0.0f);
+    normalZ.assign(laneCount, 0.0f);
+
+    // Unused slots point at joint 0 with weight 0, so they add nothing
+    blockSlots.assign(blockCount, 0);
+    slotJoints.assign(laneCount * slotCount, 0);
+    slotWeights.assign(laneCount * slotCount, 0.0f);
+
+    std::vector<SkinWeights::Influence> sorted;
+
+    for (size_t i = 0; i < laneCount; ++i) {
+        unsigned int v = laneVertex[i];
+        if (v >= vertexCount) continue;
+
+        size_t block = i / BLOCK_SIZE;
+        size_t lane = i % BLOCK_SIZE;
+        int count = influenceCount(v);
+
+        bindX[i] = bindVertices[v].x;
+        bindY[i] = bindVertices[v].y;
+        bindZ[i] = bindVertices[v].z;
+        normalX[i] = bindNormals[v].x;
+        normalY[i] = bindNormals[v].y;
+        normalZ[i] = bindNormals[v].z;
+
+        blockSlots[block] = std::max(blockSlots[block], count);
+
+        // Heaviest first: dual quaternion blending uses slot 0 as its pivot
+        sorted.assign(influences.begin() + offsets[v], influences.begin() + offsets[v + 1]);
+        std::stable_sort(sorted.begin(), sorted.end(),
+                         [](const SkinWeights::Influence& a, const SkinWeights::Influence& b) { return a.weight > b.weight; });
+
+        for (int s = 0; s < count; ++s) {
+            size_t index = (block * slotCount + s) * BLOCK_SIZE + lane;
+            slotJoints[index] = sorted[s].jointIndex;
+            slotWeights[index] = sorted[s].weight;
+        }
+    }
+}
+
+void SkinningKernel::skin(const std::vector<glm::mat4>& palette, size_t begin, size_t end, glm::vec3* out, glm::vec3* outNormals) const {
+
+    end = std::min(end, vertexCount);
+    if (begin >= end || palette.empty()) return;
+
+    size_t firstBlock, lastBlock;
+    getBlockRange(begin, end, firstBlock, lastBlock);
+
+    const float* paletteData = glm::value_ptr(palette[0]);
+
+    switch (instructionSet) {
+        case AVX2: skinAVX2(paletteData, firstBlock, lastBlock, begin, end, out, outNormals); break;
+        case SSE4: skinSSE4(paletteData, firstBlock, lastBlock, begin, end, out, outNormals); break;
+        default:   skinScalar(paletteData, firstBlock, lastBlock, begin, end, out, outNormals); break;
+    }
+}
+
+void SkinningKernel::skinDualQuaternion(const std::vector<DualQuaternion>& palette, size_t begin, size_t end, glm::vec3* out, glm::vec3* outNormals) const {
+
+    end = std::min(end, vertexCount);
+    if (begin >= end || palette.empty()) return;
+
+    size_t firstBlock, lastBlock;
+    getBlockRange(begin, end, firstBlock, lastBlock);
+
+    const float* paletteData = &palette[0].real.x;
+
+    switch (instructionSet) {
+        case AVX2: skinDualQuaternionAVX2(paletteData, firstBlock, lastBlock, begin, end, out, outNormals); break;
+        case SSE4: skinDualQuaternionSSE4(paletteData, firstBlock, lastBlock, begin, end, out, outNormals); break;
+        default:   skinDualQuaternionScalar(paletteData, firstBlock, lastBlock, begin, end, out, outNormals); break;
+    }
+}
+
+void SkinningKernel::getBlockRange(size_t begin, size_t end, size_t& firstBlock, size_t& lastBlock) const {
+    // Vertices only move within their window, so whole windows cover the range
+    const size_t blocksPerWindow = SORT_WINDOW / BLOCK_SIZE;
+    firstBlock = (begin / SORT_WINDOW) * blocksPerWindow;
+    lastBlock = std::min(blockCount, ((end + SORT_WINDOW - 1) / SORT_WINDOW) * blocksPerWindow);
+}
+
+size_t SkinningKernel::getVertexCount() const { return vertexCount; }
+
+size_t SkinningKernel::getMemoryUsage() const {
+    return laneVertex.capacity() * sizeof(unsigned int) +
+           (bindX.capacity() + bindY.capacity() + bindZ.capacity() + normalX.capacity() + normalY.capacity() +
+            normalZ.capacity() + slotWeights.capacity()) * sizeof(float) +
+           (blockSlots.capacity() + slotJoints.capacity()) * sizeof(int);
+}
+
+SkinningKernel::InstructionSet SkinningKernel::getInstructionSet() const { return instructionSet; }
+
+void SkinningKernel::setInstructionSet(InstructionSet set) {
+    instructionSet = std::min(set, detectInstructionSet());
+}
+
+SkinningKernel::InstructionSet SkinningKernel::detectInstructionSet() {
+#if SKINNING_KERNEL_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) return AVX2;
+    if (__builtin_cpu_supports("sse4.1")) return SSE4;
+#endif
+    return SCALAR;
+}
+
+const char* SkinningKernel::getInstructionSetName(InstructionSet set) {
+    switch (set) {
+        case AVX2: return "AVX2";
+        case SSE4: return "SSE4";
+        default:   return "Scalar";
+    }
+}
+
+// Scatter one block's lanes back to their original AoS positions
+void SkinningKernel::storeBlock(const float* x, const float* y, const float* z, const float* nx, const float* ny, const float* nz,
+                                size_t block, size_t begin, size_t end, glm::vec3* out, glm::vec3* outNormals) const {
+    const unsigned int* vertex = laneVertex.data() + block * BLOCK_SIZE;
+
+    for (int lane = 0; lane < BLOCK_SIZE; ++lane) {
+        if (vertex[lane] < begin || vertex[lane] >= end) continue;
+        out[vertex[lane]] = glm::vec3(x[lane], y[lane], z[lane]);
+        outNormals[vertex[lane]] = glm::vec3(nx[lane], ny[lane], nz[lane]);
+    }
+}
+
+void SkinningKernel::skinScalar(const float* palette, size_t firstBlock, size_t lastBlock,
+                                size_t begin, size_t end, glm::vec3* out, glm::vec3* outNormals) const {
+
+    float x[BLOCK_SIZE], y[BLOCK_SIZE], z[BLOCK_SIZE];
+    float nx[BLOCK_SIZE], ny[BLOCK_SIZE], nz[BLOCK_SIZE];
+
+    for (size_t b = firstBlock; b < lastBlock; ++b) {
+        size_t base = b * BLOCK_SIZE;
+        const int* joints = slotJoints.data() + b * slotCount * BLOCK_SIZE;
+        const float* weights = slotWeights.data() + b * slotCount * BLOCK_SIZE;
+
+        for (int lane = 0; lane < BLOCK_SIZE; ++lane) {
+            float px = bindX[base + lane], py = bindY[base + lane], pz = bindZ[base + lane];
+            float qx = normalX[base + lane], qy = normalY[base + lane], qz = normalZ[base + lane];
+            float ox = 0.0f, oy = 0.0f, oz = 0.0f;
+            float mx = 0.0f, my = 0.0f, mz = 0.0f;
+
+            for (int s = 0; s < blockSlots[b]; ++s) {
+                // Column-major palette: element (row r, column c) is at c * 4 + r
+                const float* m = palette + joints[s * BLOCK_SIZE + lane] * 16;
+                float w = weights[s * BLOCK_SIZE + lane];
+
+                ox += w * (m[0] * px + m[4] * py + m[8]  * pz + m[12]);
+                oy += w * (m[1] * px + m[5] * py + m[9]  * pz + m[13]);
+                oz += w * (m[2] * px + m[6] * py + m[10] * pz + m[14]);
+
+                // Normals use only the upper 3x3
+                mx += w * (m[0] * qx + m[4] * qy + m[8]  * qz);
+                my += w * (m[1] * qx + m[5] * qy + m[9]  * qz);
+                mz += w * (m[2] * qx + m[6] * qy + m[10] * qz);
+            }
+
+            x[lane] = ox;
+            y[lane] = oy;
+            z[lane] = oz;
+            nx[lane] = mx;
+            ny[lane] = my;
+            nz[lane] = mz;
+        }
+
+        storeBlock(x, y, z, nx, ny, nz, b, begin, end, out, outNormals);
+    }
+}
+
+void SkinningKernel::skinDualQuaternionScalar(const float* palette, size_t firstBlock, size_t lastBlock,
+                                              size_t begin, size_t end, glm::vec3* out, glm::vec3* outNormals) const {
+
+    float x[BLOCK_SIZE], y[BLOCK_SIZE], z[BLOCK_SIZE];
+    float nx[BLOCK_SIZE], ny[BLOCK_SIZE], nz[BLOCK_SIZE];
+
+    for (size_t b = firstBlock; b < lastBlock; ++b) {
+        size_t base = b * BLOCK_SIZE;
+        const int* joints = slotJoints.data() + b * slotCount * BLOCK_SIZE;
+        const float* weights = slotWeights.data() + b * slotCount * BLOCK_SIZE;
+
+        for (int lane = 0; lane < BLOCK_SIZE; ++lane) {
+            const float* pivot = palette + joints[lane] * 8;
+            float blend[8] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+
+            for (int s = 0; s < blockSlots[b]; ++s) {
+                // Real part x, y, z, w then dual part x, y, z, w
+                const float* q = palette + joints[s * BLOCK_SIZE + lane] * 8;
+                float w = weights[s * BLOCK_SIZE + lane];
+
+                // q and -q are the same transform; blend in the pivot's hemisphere
+                if (q[0] * pivot[0] + q[1] * pivot[1] + q[2] * pivot[2] + q[3] * pivot[3] < 0.0f) w = -w;
+
+                for (int k = 0; k < 8; ++k) blend[k] += w * q[k];
+            }
+
+            // Padding lanes have no weight and stay at the origin
+            float lengthSq = blend[0] * blend[0] + blend[1] * blend[1] + blend[2] * blend[2] + blend[3] * blend[3];
+            float inv = lengthSq > 0.0f ? 1.0f / std::sqrt(lengthSq) : 0.0f;
+
+            float rx = blend[0] * inv, ry = blend[1] * inv, rz = blend[2] * inv, rw = blend[3] * inv;
+            float dx = blend[4] * inv, dy = blend[5] * inv, dz = blend[6] * inv, dw = blend[7] * inv;
+            float px = bindX[base + lane], py = bindY[base + lane], pz = bindZ[base + lane];
+
+            // p + 2 r x (r x p + rw p) + 2 (rw d - dw r + r x d)
+            float cx = ry * pz - rz * py + rw * px;
+            float cy = rz * px - rx * pz + rw * py;
+            float cz = rx * py - ry * px + rw * pz;
+
+            x[lane] = px + 2.0f * (ry * cz - rz * cy) + 2.0f * (rw * dx - dw * rx + ry * dz - rz * dy);
+            y[lane] = py + 2.0f * (rz * cx - rx * cz) + 2.0f * (rw * dy - dw * ry + rz * dx - rx * dz);
+            z[lane] = pz + 2.0f * (rx * cy - ry * cx) + 2.0f * (rw * dz - dw * rz + rx * dy - ry * dx);
+
+            // The normal is only rotated: n + 2 r x (r x n + rw n)
+            float qx = normalX[base + lane], qy = normalY[base + lane], qz = normalZ[base + lane];
+            float ex = ry * qz - rz * qy + rw * qx;
+            float ey = rz * qx - rx * qz + rw * qy;
+            float ez = rx * qy - ry * qx + rw * qz;
+
+            nx[lane] = qx + 2.0f * (ry * ez - rz * ey);
+            ny[lane] = qy + 2.0f * (rz * ex - rx * ez);
+            nz[lane] = qz + 2.0f * (rx * ey - ry * ex);
+        }
+
+        storeBlock(x, y, z, nx, ny, nz, b, begin, end, out, outNormals);
+    }
+}
+
+#if SKINNING_KERNEL_X86
+
+// Load column c of four palette matrices and transpose it, so row0/1/2 each
+// hold one matrix element for the 4 vertices
+__attribute__((target("sse4.1")))
+static inline void loadColumnSSE4(const float* const* m, int c, __m128& row0, __m128& row1, __m128& row2) {
+    __m128 r0 = _mm_loadu_ps(m[0] + c * 4);
+    __m128 r1 = _mm_loadu_ps(m[1] + c * 4);
+    __m128 r2 = _mm_loadu_ps(m[2] + c * 4);
+    __m128 r3 = _mm_loadu_ps(m[3] + c * 4);
+    _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+    row0 = r0;
+    row1 = r1;
+    row2 = r2;
+}
+
+__attribute__((target("sse4.1")))
+void SkinningKernel::skinSSE4(const float* palette, size_t firstBlock, size_t lastBlock,
+                              size_t begin, size_t end, glm::vec3* out, glm::vec3* outNormals) const {
+
+    alignas(16) float x[BLOCK_SIZE], y[BLOCK_SIZE], z[BLOCK_SIZE];
+    alignas(16) float nx[BLOCK_SIZE], ny[BLOCK_SIZE], nz[BLOCK_SIZE];
+
+    for (size_t b = firstBlock; b < lastBlock; ++b) {
+        size_t base = b * BLOCK_SIZE;
+        const int* joints = slotJoints.data() + b * slotCount * BLOCK_SIZE;
+        const float* weights = slotWeights.data() + b * slotCount * BLOCK_SIZE;
+
+        // Two groups of 4 vertices per block
+        for (int half = 0; half < BLOCK_SIZE; half += 4) {
+            __m128 px = _mm_loadu_ps(&bindX[base + half]);
+            __m128 py = _mm_loadu_ps(&bindY[base + half]);
+            __m128 pz = _mm_loadu_ps(&bindZ[base + half]);
+            __m128 qx = _mm_loadu_ps(&normalX[base + half]);
+            __m128 qy = _mm_loadu_ps(&normalY[base + half]);
+            __m128 qz = _mm_loadu_ps(&normalZ[base + half]);
+
+            __m128 ox = _mm_setzero_ps();
+            __m128 oy = _mm_setzero_ps();
+            __m128 oz = _mm_setzero_ps();
+            __m128 mx = _mm_setzero_ps();
+            __m128 my = _mm_setzero_ps();
+            __m128 mz = _mm_setzero_ps();
+
+            for (int s = 0; s < blockSlots[b]; ++s) {
+                const int* j = joints + s * BLOCK_SIZE + half;
+                const float* m[4] = { palette + j[0] * 16, palette + j[1] * 16, palette + j[2] * 16, palette + j[3] * 16 };
+
+                // transformed = column0 * x + column1 * y + column2 * z + column3,
+                // and the normal through the first three columns
+                __m128 r0, r1, r2;
+                loadColumnSSE4(m, 0, r0, r1, r2);
+                __m128 tx = _mm_mul_ps(r0, px);
+                __m128 ty = _mm_mul_ps(r1, px);
+                __m128 tz = _mm_mul_ps(r2, px);
+                __m128 sx = _mm_mul_ps(r0, qx);
+                __m128 sy = _mm_mul_ps(r1, qx);
+                __m128 sz = _mm_mul_ps(r2, qx);
+
+                loadColumnSSE4(m, 1, r0, r1, r2);
+                tx = _mm_add_ps(tx, _mm_mul_ps(r0, py));
+                ty = _mm_add_ps(ty, _mm_mul_ps(r1, py));
+                tz = _mm_add_ps(tz, _mm_mul_ps(r2, py));
+                sx = _mm_add_ps(sx, _mm_mul_ps(r0, qy));
+                sy = _mm_add_ps(sy, _mm_mul_ps(r1, qy));
+                sz = _mm_add_ps(sz, _mm_mul_ps(r2, qy));
+
+                loadColumnSSE4(m, 2, r0, r1, r2);
+                tx = _mm_add_ps(tx, _mm_mul_ps(r0, pz));
+                ty = _mm_add_ps(ty, _mm_mul_ps(r1, pz));
+                tz = _mm_add_ps(tz, _mm_mul_ps(r2, pz));
+                sx = _mm_add_ps(sx, _mm_mul_ps(r0, qz));
+                sy = _mm_add_ps(sy, _mm_mul_ps(r1, qz));
+                sz = _mm_add_ps(sz, _mm_mul_ps(r2, qz));
+
+                loadColumnSSE4(m, 3, r0, r1, r2);
+                tx = _mm_add_ps(tx, r0);
+                ty = _mm_add_ps(ty, r1);
+                tz = _mm_add_ps(tz, r2);
+
+                __m128 w = _mm_loadu_ps(weights + s * BLOCK_SIZE + half);
+                ox = _mm_add_ps(ox, _mm_mul_ps(w, tx));
+                oy = _mm_add_ps(oy, _mm_mul_ps(w, ty));
+                oz = _mm_add_ps(oz, _mm_mul_ps(w, tz));
+                mx = _mm_add_ps(mx, _mm_mul_ps(w, sx));
+                my = _mm_add_ps(my, _mm_mul_ps(w, sy));
+                mz = _mm_add_ps(mz, _mm_mul_ps(w, sz));
+            }
+
+            _mm_store_ps(x + half, ox);
+            _mm_store_ps(y + half, oy);
+            _mm_store_ps(z + half, oz);
+            _mm_store_ps(nx + half, mx);
+            _mm_store_ps(ny + half, my);
+            _mm_store_ps(nz + half, mz);
+        }
+
+        storeBlock(x, y, z, nx, ny, nz, b, begin, end, out, outNormals);
+    }
+}
+
+// As loadColumnSSE4 for eight matrices: lanes 0-3 go in the low and 4-7 in
+// the high 128-bit half, since the AVX shuffles work within each half
+__attribute__((target("avx2,fma")))
+static inline void loadColumnAVX2(const float* const* m, int c, __m256& row0, __m256& row1, __m256& row2) {
+    __m256 a = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(m[0] + c * 4)), _mm_loadu_ps(m[4] + c * 4), 1);
+    __m256 b = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(m[1] + c * 4)), _mm_loadu_ps(m[5] + c * 4), 1);
+    __m256 d = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(m[2] + c * 4)), _mm_loadu_ps(m[6] + c * 4), 1);
+    __m256 e = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(m[3] + c * 4)), _mm_loadu_ps(m[7] + c * 4), 1);
+
+    __m256 lo0 = _mm256_unpacklo_ps(a, b);
+    __m256 lo1 = _mm256_unpacklo_ps(d, e);
+    __m256 hi0 = _mm256_unpackhi_ps(a, b);
+    __m256 hi1 = _mm256_unpackhi_ps(d, e);
+
+    row0 = _mm256_shuffle_ps(lo0, lo1, _MM_SHUFFLE(1, 0, 1, 0));
+    row1 = _mm256_shuffle_ps(lo0, lo1, _MM_SHUFFLE(3, 2, 3, 2));
+    row2 = _mm256_shuffle_ps(hi0, hi1, _MM_SHUFFLE(1, 0, 1, 0));
+}
+
+__attribute__((target("avx2,fma")))
+void SkinningKernel::skinAVX2(const float* palette, size_t firstBlock, size_t lastBlock,
+                              size_t begin, size_t end, glm::vec3* out, glm::vec3* outNormals) const {
+
+    alignas(32) float x[BLOCK_SIZE], y[BLOCK_SIZE], z[BLOCK_SIZE];
+    alignas(32) float nx[BLOCK_SIZE], ny[BLOCK_SIZE], nz[BLOCK_SIZE];
+
+    for (size_t b = firstBlock; b < lastBlock; ++b) {
+        size_t base = b * BLOCK_SIZE;
+        const int* joints = slotJoints.data() + b * slotCount * BLOCK_SIZE;
+        const float* weights = slotWeights.data() + b * slotCount * BLOCK_SIZE;
+
+        __m256 px = _mm256_loadu_ps(&bindX[base]);
+        __m256 py = _mm256_loadu_ps(&bindY[base]);
+        __m256 pz = _mm256_loadu_ps(&bindZ[base]);
+        __m256 qx = _mm256_loadu_ps(&normalX[base]);
+        __m256 qy = _mm256_loadu_ps(&normalY[base]);
+        __m256 qz = _mm256_loadu_ps(&normalZ[base]);
+
+        __m256 ox = _mm256_setzero_ps();
+        __m256 oy = _mm256_setzero_ps();
+        __m256 oz = _mm256_setzero_ps();
+        __m256 mx = _mm256_setzero_ps();
+        __m256 my = _mm256_setzero_ps();
+        __m256 mz = _mm256_setzero_ps();
+
+        for (int s = 0; s < blockSlots[b]; ++s) {
+            const int* j = joints + s * BLOCK_SIZE;
+            const float* m[BLOCK_SIZE];
+            for (int lane = 0; lane < BLOCK_SIZE; ++lane) m[lane] = palette + j[lane] * 16;
+
+            // transformed = column0 * x + column1 * y + column2 * z + column3
+            __m256 r0, r1, r2;
+            loadColumnAVX2(m, 3, r0, r1, r2);
+            __m256 tx = r0, ty = r1, tz = r2;
+
+            // The normal goes through the first three columns only
+            loadColumnAVX2(m, 0, r0, r1, r2);
+            tx = _mm256_fmadd_ps(r0, px, tx);
+            ty = _mm256_fmadd_ps(r1, px, ty);
+            tz = _mm256_fmadd_ps(r2, px, tz);
+            __m256 sx = _mm256_mul_ps(r0, qx);
+            __m256 sy = _mm256_mul_ps(r1, qx);
+            __m256 sz = _mm256_mul_ps(r2, qx);
+
+            loadColumnAVX2(m, 1, r0, r1, r2);
+            tx = _mm256_fmadd_ps(r0, py, tx);
+            ty = _mm256_fmadd_ps(r1, py, ty);
+            tz = _mm256_fmadd_ps(r2, py, tz);
+            sx = _mm256_fmadd_ps(r0, qy, sx);
+            sy = _mm256_fmadd_ps(r1, qy, sy);
+            sz = _mm256_fmadd_ps(r2, qy, sz);
+
+            loadColumnAVX2(m, 2, r0, r1, r2);
+            tx = _mm256_fmadd_ps(r0, pz, tx);
+            ty = _mm256_fmadd_ps(r1, pz, ty);
+            tz = _mm256_fmadd_ps(r2, pz, tz);
+            sx = _mm256_fmadd_ps(r0, qz, sx);
+            sy = _mm256_fmadd_ps(r1, qz, sy);
+            sz = _mm256_fmadd_ps(r2, qz, sz);
+
+            __m256 w = _mm256_loadu_ps(weights + s * BLOCK_SIZE);
+            ox = _mm256_fmadd_ps(w, tx, ox);
+            oy = _mm256_fmadd_ps(w, ty, oy);
+            oz = _mm256_fmadd_ps(w, tz, oz);
+            mx = _mm256_fmadd_ps(w, sx, mx);
+            my = _mm256_fmadd_ps(w, sy, my);
+            mz = _mm256_fmadd_ps(w, sz, mz);
+        }
+
+        _mm256_store_ps(x, ox);
+        _mm256_store_ps(y, oy);
+        _mm256_store_ps(z, oz);
+        _mm256_store_ps(nx, mx);
+        _mm256_store_ps(ny, my);
+        _mm256_store_ps(nz, mz);
+
+        // Scatter inline rather than through storeBlock, which is compiled
+        // without VEX encoding and would cost an SSE/AVX transition per block
+        const unsigned int* vertex = laneVertex.data() + base;
+        for (int lane = 0; lane < BLOCK_SIZE; ++lane) {
+            if (vertex[lane] < begin || vertex[lane] >= end) continue;
+            out[vertex[lane]] = glm::vec3(x[lane], y[lane], z[lane]);
+            outNormals[vertex[lane]] = glm::vec3(nx[lane], ny[lane], nz[lane]);
+        }
+    }
+}
+
+// Load part (0 = real, 1 = dual) of four dual quaternions and transpose it,
+// so x/y/z/w each hold one component for the 4 vertices
+__attribute__((target("sse4.1")))
+static inline void loadQuaternionsSSE4(const float* const* q, int part, __m128& x, __m128& y, __m128& z, __m128& w) {
+    x = _mm_loadu_ps(q[0] + part * 4);
+    y = _mm_loadu_ps(q[1] + part * 4);
+    z = _mm_loadu_ps(q[2] + part * 4);
+    w = _mm_loadu_ps(q[3] + part * 4);
+    _MM_TRANSPOSE4_PS(x, y, z, w);
+}
+
+// a * b - c * d
+__attribute__((target("sse4.1")))
+static inline __m128 mulSubSSE4(__m128 a, __m128 b, __m128 c, __m128 d) {
+    return _mm_sub_ps(_mm_mul_ps(a, b), _mm_mul_ps(c, d));
+}
+
+__attribute__((target("sse4.1")))
+void SkinningKernel::skinDualQuaternionSSE4(const float* palette, size_t firstBlock, size_t lastBlock,
+                                            size_t begin, size_t end, glm::vec3* out, glm::vec3* outNormals) const {
+
+    alignas(16) float x[BLOCK_SIZE], y[BLOCK_SIZE], z[BLOCK_SIZE];
+    alignas(16) float nx[BLOCK_SIZE], ny[BLOCK_SIZE], nz[BLOCK_SIZE];
+
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 two = _mm_set1_ps(2.0f);
+    const __m128 signBit = _mm_set1_ps(-0.0f);
+
+    for (size_t b = firstBlock; b < lastBlock; ++b) {
+        size_t base = b * BLOCK_SIZE;
+        const int* joints = slotJoints.data() + b * slotCount * BLOCK_SIZE;
+        const float* weights = slotWeights.data() + b * slotCount * BLOCK_SIZE;
+
+        // Two groups of 4 vertices per block
+        for (int half = 0; half < BLOCK_SIZE; half += 4) {
+            __m128 brx = zero, bry = zero, brz = zero, brw = zero;
+            __m128 bdx = zero, bdy = zero, bdz = zero, bdw = zero;
+            __m128 pivotX = zero, pivotY = zero, pivotZ = zero, pivotW = zero;
+
+            for (int s = 0; s < blockSlots[b]; ++s) {
+                const int* j = joints + s * BLOCK_SIZE + half;
+                const float* q[4] = { palette + j[0] * 8, palette + j[1] * 8, palette + j[2] * 8, palette + j[3] * 8 };
+
+                __m128 rx, ry, rz, rw, dx, dy, dz, dw;
+                loadQuaternionsSSE4(q, 0, rx, ry, rz, rw);
+                loadQuaternionsSSE4(q, 1, dx, dy, dz, dw);
+
+                if (s == 0) {
+                    pivotX = rx; pivotY = ry; pivotZ = rz; pivotW = rw;
+                }
+
+                __m128 dot = _mm_add_ps(_mm_add_ps(_mm_mul_ps(rx, pivotX), _mm_mul_ps(ry, pivotY)),
+                                        _mm_add_ps(_mm_mul_ps(rz, pivotZ), _mm_mul_ps(rw, pivotW)));
+
+                __m128 w = _mm_loadu_ps(weights + s * BLOCK_SIZE + half);
+                w = _mm_xor_ps(w, _mm_and_ps(_mm_cmplt_ps(dot, zero), signBit));
+
+                brx = _mm_add_ps(brx, _mm_mul_ps(w, rx));
+                bry = _mm_add_ps(bry, _mm_mul_ps(w, ry));
+                brz = _mm_add_ps(brz, _mm_mul_ps(w, rz));
+                brw = _mm_add_ps(brw, _mm_mul_ps(w, rw));
+                bdx = _mm_add_ps(bdx, _mm_mul_ps(w, dx));
+                bdy = _mm_add_ps(bdy, _mm_mul_ps(w, dy));
+                bdz = _mm_add_ps(bdz, _mm_mul_ps(w, dz));
+                bdw = _mm_add_ps(bdw, _mm_mul_ps(w, dw));
+            }
+
+            __m128 lengthSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(brx, brx), _mm_mul_ps(bry, bry)),
+                                         _mm_add_ps(_mm_mul_ps(brz, brz), _mm_mul_ps(brw, brw)));
+            __m128 inv = _mm_div_ps(one, _mm_sqrt_ps(lengthSq));
+            inv = _mm_and_ps(inv, _mm_cmpgt_ps(lengthSq, zero));
+
+            __m128 rx = _mm_mul_ps(brx, inv), ry = _mm_mul_ps(bry, inv);
+            __m128 rz = _mm_mul_ps(brz, inv), rw = _mm_mul_ps(brw, inv);
+            __m128 dx = _mm_mul_ps(bdx, inv), dy = _mm_mul_ps(bdy, inv);
+            __m128 dz = _mm_mul_ps(bdz, inv), dw = _mm_mul_ps(bdw, inv);
+
+            __m128 px = _mm_loadu_ps(&bindX[base + half]);
+            __m128 py = _mm_loadu_ps(&bindY[base + half]);
+            __m128 pz = _mm_loadu_ps(&bindZ[base + half]);
+
+            // c = r x p + rw p, t = rw d - dw r + r x d, then p + 2 (r x c) + 2 t
+            __m128 cx = _mm_add_ps(mulSubSSE4(ry, pz, rz, py), _mm_mul_ps(rw, px));
+            __m128 cy = _mm_add_ps(mulSubSSE4(rz, px, rx, pz), _mm_mul_ps(rw, py));
+            __m128 cz = _mm_add_ps(mulSubSSE4(rx, py, ry, px), _mm_mul_ps(rw, pz));
+
+            __m128 tx = _mm_add_ps(mulSubSSE4(rw, dx, dw, rx), mulSubSSE4(ry, dz, rz, dy));
+            __m128 ty = _mm_add_ps(mulSubSSE4(rw, dy, dw, ry), mulSubSSE4(rz, dx, rx, dz));
+            __m128 tz = _mm_add_ps(mulSubSSE4(rw, dz, dw, rz), mulSubSSE4(rx, dy, ry, dx));
+
+            __m128 ox = _mm_add_ps(mulSubSSE4(ry, cz, rz, cy), tx);
+            __m128 oy = _mm_add_ps(mulSubSSE4(rz, cx, rx, cz), ty);
+            __m128 oz = _mm_add_ps(mulSubSSE4(rx, cy, ry, cx), tz);
+
+            _mm_store_ps(x + half, _mm_add_ps(px, _mm_mul_ps(two, ox)));
+            _mm_store_ps(y + half, _mm_add_ps(py, _mm_mul_ps(two, oy)));
+            _mm_store_ps(z + half, _mm_add_ps(pz, _mm_mul_ps(two, oz)));
+
+            // The normal is only rotated: n + 2 r x (r x n + rw n)
+            __m128 qx = _mm_loadu_ps(&normalX[base + half]);
+            __m128 qy = _mm_loadu_ps(&normalY[base + half]);
+            __m128 qz = _mm_loadu_ps(&normalZ[base + half]);
+
+            __m128 ex = _mm_add_ps(mulSubSSE4(ry, qz, rz, qy), _mm_mul_ps(rw, qx));
+            __m128 ey = _mm_add_ps(mulSubSSE4(rz, qx, rx, qz), _mm_mul_ps(rw, qy));
+            __m128 ez = _mm_add_ps(mulSubSSE4(rx, qy, ry, qx), _mm_mul_ps(rw, qz));
+
+            _mm_store_ps(nx + half, _mm_add_ps(qx, _mm_mul_ps(two, mulSubSSE4(ry, ez, rz, ey))));
+            _mm_store_ps(ny + half, _mm_add_ps(qy, _mm_mul_ps(two, mulSubSSE4(rz, ex, rx, ez))));
+            _mm_store_ps(nz + half, _mm_add_ps(qz, _mm_mul_ps(two, mulSubSSE4(rx, ey, ry, ex))));
+        }
+
+        storeBlock(x, y, z, nx, ny, nz, b, begin, end, out, outNormals);
+    }
+}
+
+// Load part (0 = real, 1 = dual) of eight dual quaternions and transpose it,
+// so x/y/z/w each hold one component for the 8 vertices
+__attribute__((target("avx2,fma")))
+static inline void loadQuaternionsAVX2(const float* const* q, int part, __m256& x, __m256& y, __m256& z, __m256& w) {
+    __m256 a = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(q[0] + part * 4)), _mm_loadu_ps(q[4] + part * 4), 1);
+    __m256 b = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(q[1] + part * 4)), _mm_loadu_ps(q[5] + part * 4), 1);
+    __m256 d = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(q[2] + part * 4)), _mm_loadu_ps(q[6] + part * 4), 1);
+    __m256 e = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(q[3] + part * 4)), _mm_loadu_ps(q[7] + part * 4), 1);
+
+    __m256 lo0 = _mm256_unpacklo_ps(a, b);
+    __m256 lo1 = _mm256_unpacklo_ps(d, e);
+    __m256 hi0 = _mm256_unpackhi_ps(a, b);
+    __m256 hi1 = _mm256_unpackhi_ps(d, e);
+
+    x = _mm256_shuffle_ps(lo0, lo1, _MM_SHUFFLE(1, 0, 1, 0));
+    y = _mm256_shuffle_ps(lo0, lo1, _MM_SHUFFLE(3, 2, 3, 2));
+    z = _mm256_shuffle_ps(hi0, hi1, _MM_SHUFFLE(1, 0, 1, 0));
+    w = _mm256_shuffle_ps(hi0, hi1, _MM_SHUFFLE(3, 2, 3, 2));
+}
+
+__attribute__((target("avx2,fma")))
+void SkinningKernel::skinDualQuaternionAVX2(const float* palette, size_t firstBlock, size_t lastBlock,
+                                            size_t begin, size_t end, glm::vec3* out, glm::vec3* outNormals) const {
+
+    alignas(32) float x[BLOCK_SIZE], y[BLOCK_SIZE], z[BLOCK_SIZE];
+    alignas(32) float nx[BLOCK_SIZE], ny[BLOCK_SIZE], nz[BLOCK_SIZE];
+
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 two = _mm256_set1_ps(2.0f);
+    const __m256 signBit = _mm256_set1_ps(-0.0f);
+
+    for (size_t b = firstBlock; b < lastBlock; ++b) {
+        size_t base = b * BLOCK_SIZE;
+        const int* joints = slotJoints.data() + b * slotCount * BLOCK_SIZE;
+        const float* weights = slotWeights.data() + b * slotCount * BLOCK_SIZE;
+
+        __m256 brx = zero, bry = zero, brz = zero, brw = zero;
+        __m256 bdx = zero, bdy = zero, bdz = zero, bdw = zero;
+        __m256 pivotX = zero, pivotY = zero, pivotZ = zero, pivotW = zero;
+
+        for (int s = 0; s < blockSlots[b]; ++s) {
+            const int* j = joints + s * BLOCK_SIZE;
+            const float* q[BLOCK_SIZE];
+            for (int lane = 0; lane < BLOCK_SIZE; ++lane) q[lane] = palette + j[lane] * 8;
+
+            __m256 rx, ry, rz, rw, dx, dy, dz, dw;
+            loadQuaternionsAVX2(q, 0, rx, ry, rz, rw);
+            loadQuaternionsAVX2(q, 1, dx, dy, dz, dw);
+
+            // Slot 0 is each vertex's heaviest joint
+            if (s == 0) {
+                pivotX = rx; pivotY = ry; pivotZ = rz; pivotW = rw;
+            }
+
+            __m256 dot = _mm256_mul_ps(rx, pivotX);
+            dot = _mm256_fmadd_ps(ry, pivotY, dot);
+            dot = _mm256_fmadd_ps(rz, pivotZ, dot);
+            dot = _mm256_fmadd_ps(rw, pivotW, dot);
+
+            // Negate the weight where q lies in the other hemisphere
+            __m256 w = _mm256_loadu_ps(weights + s * BLOCK_SIZE);
+            w = _mm256_xor_ps(w, _mm256_and_ps(_mm256_cmp_ps(dot, zero, _CMP_LT_OQ), signBit));
+
+            brx = _mm256_fmadd_ps(w, rx, brx);
+            bry = _mm256_fmadd_ps(w, ry, bry);
+            brz = _mm256_fmadd_ps(w, rz, brz);
+            brw = _mm256_fmadd_ps(w, rw, brw);
+            bdx = _mm256_fmadd_ps(w, dx, bdx);
+            bdy = _mm256_fmadd_ps(w, dy, bdy);
+            bdz = _mm256_fmadd_ps(w, dz, bdz);
+            bdw = _mm256_fmadd_ps(w, dw, bdw);
+        }
+
+        // Normalize by the real part; padding lanes (length 0) get a zero scale
+        __m256 lengthSq = _mm256_mul_ps(brx, brx);
+        lengthSq = _mm256_fmadd_ps(bry, bry, lengthSq);
+        lengthSq = _mm256_fmadd_ps(brz, brz, lengthSq);
+        lengthSq = _mm256_fmadd_ps(brw, brw, lengthSq);
+        __m256 inv = _mm256_div_ps(one, _mm256_sqrt_ps(lengthSq));
+        inv = _mm256_and_ps(inv, _mm256_cmp_ps(lengthSq, zero, _CMP_GT_OQ));
+
+        __m256 rx = _mm256_mul_ps(brx, inv), ry = _mm256_mul_ps(bry, inv);
+        __m256 rz = _mm256_mul_ps(brz, inv), rw = _mm256_mul_ps(brw, inv);
+        __m256 dx = _mm256_mul_ps(bdx, inv), dy = _mm256_mul_ps(bdy, inv);
+        __m256 dz = _mm256_mul_ps(bdz, inv), dw = _mm256_mul_ps(bdw, inv);
+
+        __m256 px = _mm256_loadu_ps(&bindX[base]);
+        __m256 py = _mm256_loadu_ps(&bindY[base]);
+        __m256 pz = _mm256_loadu_ps(&bindZ[base]);
+
+        // c = r x p + rw p
+        __m256 cx = _mm256_fmadd_ps(rw, px, _mm256_fmsub_ps(ry, pz, _mm256_mul_ps(rz, py)));
+        __m256 cy = _mm256_fmadd_ps(rw, py, _mm256_fmsub_ps(rz, px, _mm256_mul_ps(rx, pz)));
+        __m256 cz = _mm256_fmadd_ps(rw, pz, _mm256_fmsub_ps(rx, py, _mm256_mul_ps(ry, px)));
+
+        // t = rw d - dw r + r x d, then p + 2 (r x c) + 2 t
+        __m256 tx = _mm256_fnmadd_ps(dw, rx, _mm256_fmadd_ps(rw, dx, _mm256_fmsub_ps(ry, dz, _mm256_mul_ps(rz, dy))));
+        __m256 ty = _mm256_fnmadd_ps(dw, ry, _mm256_fmadd_ps(rw, dy, _mm256_fmsub_ps(rz, dx, _mm256_mul_ps(rx, dz))));
+        __m256 tz = _mm256_fnmadd_ps(dw, rz, _mm256_fmadd_ps(rw, dz, _mm256_fmsub_ps(rx, dy, _mm256_mul_ps(ry, dx))));
+
+        __m256 ox = _mm256_add_ps(_mm256_fmsub_ps(ry, cz, _mm256_mul_ps(rz, cy)), tx);
+        __m256 oy = _mm256_add_ps(_mm256_fmsub_ps(rz, cx, _mm256_mul_ps(rx, cz)), ty);
+        __m256 oz = _mm256_add_ps(_mm256_fmsub_ps(rx, cy, _mm256_mul_ps(ry, cx)), tz);
+
+        _mm256_store_ps(x, _mm256_fmadd_ps(two, ox, px));
+        _mm256_store_ps(y, _mm256_fmadd_ps(two, oy, py));
+        _mm256_store_ps(z, _mm256_fmadd_ps(two, oz, pz));
+
+        // The normal is only rotated: n + 2 r x (r x n + rw n)
+        __m256 qx = _mm256_loadu_ps(&normalX[base]);
+        __m256 qy = _mm256_loadu_ps(&normalY[base]);
+        __m256 qz = _mm256_loadu_ps(&normalZ[base]);
+
+        __m256 ex = _mm256_fmadd_ps(rw, qx, _mm256_fmsub_ps(ry, qz, _mm256_mul_ps(rz, qy)));
+        __m256 ey = _mm256_fmadd_ps(rw, qy, _mm256_fmsub_ps(rz, qx, _mm256_mul_ps(rx, qz)));
+        __m256 ez = _mm256_fmadd_ps(rw, qz, _mm256_fmsub_ps(rx, qy, _mm256_mul_ps(ry, qx)));
+
+        _mm256_store_ps(nx, _mm256_fmadd_ps(two, _mm256_fmsub_ps(ry, ez, _mm256_mul_ps(rz, ey)), qx));
+        _mm256_store_ps(ny, _mm256_fmadd_ps(two, _mm256_fmsub_ps(rz, ex, _mm256_mul_ps(rx, ez)), qy));
+        _mm256_store_ps(nz, _mm256_fmadd_ps(two, _mm256_fmsub_ps(rx, ey, _mm256_mul_ps(ry, ex)), qz));
+
+        // Scatter inline, as in skinAVX2
+        const unsigned int* vertex = laneVertex.data() + base;
+        for (int lane = 0; lane < BLOCK_SIZE; ++lane) {
+            if (vertex[lane] < begin || vertex[lane] >= end) continue;
+            out[vertex[lane]] = glm::vec3(x[lane], y[lane], z[lane]);
+            outNormals[vertex[lane]] = glm::vec3(nx[lane], ny[lane], nz[lane]);
+        }
+    }
+}
+
+#else
+
+// Non-x86 builds never select the vector paths
+void SkinningKernel::skinSSE4(const float* palette, size_t firstBlock, size_t lastBlock,
+                              size_t begin, size_t end, glm::vec3* out, glm::vec3* outNormals) const {
+    skinScalar(palette, firstBlock, lastBlock, begin, end, out, outNormals);
+}
+
+void SkinningKernel::skinAVX2(const float* palette, size_t firstBlock, size_t lastBlock,
+                              size_t begin, size_t end, glm::vec3* out, glm::vec3* outNormals) const {
+    skinScalar(palette, firstBlock, lastBlock, begin, end, out, outNormals);
+}
+
+void SkinningKernel::skinDualQuaternionSSE4(const float* palette, size_t firstBlock, size_t lastBlock,
+                                            size_t begin, size_t end, glm::vec3* out, glm::vec3* outNormals) const {
+    skinDualQuaternionScalar(palette, firstBlock, lastBlock, begin, end, out, outNormals);
+}
+
+void SkinningKernel::skinDualQuaternionAVX2(const float* palette, size_t firstBlock, size_t lastBlock,
+                                            size_t begin, size_t end, glm::vec3* out, glm::vec3* outNormals) const {
+    skinDualQuaternionScalar(palette, firstBlock, lastBlock, begin, end, out, outNormals);
+}
+
+#endif
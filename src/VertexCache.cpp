@@ -0,0 +1,190 @@
+#include "VertexCache.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+static_assert(sizeof(VertexCache::Header) == 32, "VertexCache::Header must be 32 packed bytes");
+
+static const char VERTEX_CACHE_MAGIC[4] = { 'H', 'M', 'V', 'C' };
+
+VertexCache::VertexCache() : decodedFrame(0) {
+    fillHeader(header, 0, 0, DEFAULT_KEYFRAME_INTERVAL, 1.0f, 0);
+}
+
+bool VertexCache::open(const std::string& path) {
+    close();
+
+    if (!file.open(path)) return false;
+
+    if (file.getSize() < sizeof(Header)) {
+        close();
+        return false;
+    }
+    std::memcpy(&header, file.getData(), sizeof(Header));
+
+    // The index must fit in the file, and so must the frame data it points to
+    uint64_t indexSize = (static_cast<uint64_t>(header.frameCount) + 1) * sizeof(uint64_t);
+    if (!isValidHeader(header) || header.indexOffset > file.getSize() ||
+        indexSize > file.getSize() - header.indexOffset ||
+        getFrameOffset(header.frameCount) > header.indexOffset) {
+        close();
+        return false;
+    }
+
+    state.assign(static_cast<size_t>(header.vertexCount) * COMPONENTS, 0);
+    decodedFrame = header.frameCount;
+    return true;
+}
+
+void VertexCache::close() {
+    file.close();
+    fillHeader(header, 0, 0, DEFAULT_KEYFRAME_INTERVAL, 1.0f, 0);
+    state.clear();
+    decodedFrame = 0;
+}
+
+bool VertexCache::isOpen() const { return file.isOpen(); }
+size_t VertexCache::getVertexCount() const { return header.vertexCount; }
+size_t VertexCache::getFrameCount() const { return header.frameCount; }
+float VertexCache::getPositionStep() const { return header.positionStep; }
+size_t VertexCache::getFileSize() const { return file.getSize(); }
+
+bool VertexCache::readFrame(size_t frame, glm::vec3* positions, glm::vec3* normals) {
+    if (!isOpen() || frame >= header.frameCount) return false;
+
+    size_t keyframe = frame - frame % header.keyframeInterval;
+    size_t start = keyframe;
+    if (decodedFrame < header.frameCount && decodedFrame >= keyframe && decodedFrame <= frame) {
+        start = decodedFrame + 1;
+    }
+
+    for (size_t f = start; f <= frame; ++f) {
+        if (!decodeFrame(f)) {
+            decodedFrame = header.frameCount;
+            return false;
+        }
+    }
+
+    // Page in the next frames while this one is uploaded
+    size_t last = std::min<size_t>(header.frameCount, frame + 1 + PREFETCH_FRAMES);
+    uint64_t begin = getFrameOffset(frame + 1);
+    file.prefetch(static_cast<size_t>(begin), static_cast<size_t>(getFrameOffset(last) - begin));
+
+    float step = header.positionStep;
+    for (size_t i = 0; i < header.vertexCount; ++i) {
+        const int32_t* q = &state[i * COMPONENTS];
+        positions[i] = glm::vec3(q[0] * step, q[1] * step, q[2] * step);
+        normals[i] = decodeNormal(q[3], q[4]);
+    }
+
+    return true;
+}
+
+uint64_t VertexCache::getFrameOffset(size_t frame) const {
+    uint64_t offset;
+    std::memcpy(&offset, file.getData() + header.indexOffset + frame * sizeof(uint64_t), sizeof(uint64_t));
+    return offset;
+}
+
+bool VertexCache::decodeFrame(size_t frame) {
+    uint64_t begin = getFrameOffset(frame);
+    uint64_t end = getFrameOffset(frame + 1);
+    if (begin > end || end > header.indexOffset) return false;
+
+    // Keyframes are differences from zero
+    if (frame % header.keyframeInterval == 0) std::fill(state.begin(), state.end(), 0);
+
+    const unsigned char* in = file.getData() + begin;
+    const unsigned char* inEnd = file.getData() + end;
+
+    for (int32_t& value : state) {
+        int32_t delta;
+        in = readVarint(in, inEnd, delta);
+        if (!in) return false;
+        value += delta;
+    }
+
+    decodedFrame = frame;
+    return true;
+}
+
+bool VertexCache::isValidHeader(const Header& header) {
+    return std::memcmp(header.magic, VERTEX_CACHE_MAGIC, sizeof(VERTEX_CACHE_MAGIC)) == 0 &&
+           header.version == VERSION && header.keyframeInterval > 0 && header.positionStep > 0.0f;
+}
+
+void VertexCache::fillHeader(Header& header, uint32_t vertexCount, uint32_t frameCount,
+                             uint32_t keyframeInterval, float positionStep, uint64_t indexOffset) {
+    std::memcpy(header.magic, VERTEX_CACHE_MAGIC, sizeof(VERTEX_CACHE_MAGIC));
+    header.version = VERSION;
+    header.vertexCount = vertexCount;
+    header.frameCount = frameCount;
+    header.keyframeInterval = keyframeInterval;
+    header.positionStep = positionStep;
+    header.indexOffset = indexOffset;
+}
+
+unsigned char* VertexCache::writeVarint(int32_t value, unsigned char* out) {
+    // Zigzag: small magnitudes of either sign become small unsigned values
+    uint32_t bits = (static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31);
+
+    while (bits >= 0x80) {
+        *out++ = static_cast<unsigned char>(bits | 0x80);
+        bits >>= 7;
+    }
+    *out++ = static_cast<unsigned char>(bits);
+    return out;
+}
+
+const unsigned char* VertexCache::readVarint(const unsigned char* in, const unsigned char* end, int32_t& value) {
+    uint32_t bits = 0;
+    int shift = 0;
+
+    while (in < end && shift < 35) {
+        unsigned char byte = *in++;
+        bits |= static_cast<uint32_t>(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            value = static_cast<int32_t>(bits >> 1) ^ -static_cast<int32_t>(bits & 1);
+            return in;
+        }
+        shift += 7;
+    }
+
+    return nullptr; // Truncated or corrupt
+}
+
+void VertexCache::encodeNormal(const glm::vec3& normal, int32_t& u, int32_t& v) {
+    // Octahedral mapping: project onto |x| + |y| + |z| = 1 and fold the lower half out
+    float sum = std::fabs(normal.x) + std::fabs(normal.y) + std::fabs(normal.z);
+    if (sum <= 0.0f) {
+        u = v = 0;
+        return;
+    }
+
+    float x = normal.x / sum, y = normal.y / sum;
+    if (normal.z < 0.0f) {
+        float foldedX = (1.0f - std::fabs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+        float foldedY = (1.0f - std::fabs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+        x = foldedX;
+        y = foldedY;
+    }
+
+    u = static_cast<int32_t>(std::lround(x * NORMAL_SCALE));
+    v = static_cast<int32_t>(std::lround(y * NORMAL_SCALE));
+}
+
+glm::vec3 VertexCache::decodeNormal(int32_t u, int32_t v) {
+    float x = static_cast<float>(u) / NORMAL_SCALE;
+    float y = static_cast<float>(v) / NORMAL_SCALE;
+    float z = 1.0f - std::fabs(x) - std::fabs(y);
+
+    if (z < 0.0f) {
+        float unfoldedX = (1.0f - std::fabs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+        float unfoldedY = (1.0f - std::fabs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+        x = unfoldedX;
+        y = unfoldedY;
+    }
+
+    return glm::normalize(glm::vec3(x, y, z));
+}
@@ -0,0 +1,95 @@
+#include "VertexCacheWriter.h"
+
+#include <cmath>
+
+VertexCacheWriter::VertexCacheWriter()
+    : vertexCount(0), keyframeInterval(VertexCache::DEFAULT_KEYFRAME_INTERVAL), positionStep(1.0f) {}
+
+VertexCacheWriter::~VertexCacheWriter() {
+    close();
+}
+
+bool VertexCacheWriter::open(const std::string& path, size_t vertexCount, float positionStep, uint32_t keyframeInterval) {
+    close();
+
+    if (positionStep <= 0.0f || keyframeInterval == 0) return false;
+
+    file.open(path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) return false;
+
+    this->vertexCount = static_cast<uint32_t>(vertexCount);
+    this->positionStep = positionStep;
+    this->keyframeInterval = keyframeInterval;
+
+    previous.assign(vertexCount * VertexCache::COMPONENTS, 0);
+    frameOffsets.assign(1, sizeof(VertexCache::Header));
+    buffer.resize(previous.size() * 5); // A varint of a 32-bit value is at most 5 bytes
+
+    // Placeholder until close() knows the frame count and index offset
+    VertexCache::Header header;
+    VertexCache::fillHeader(header, this->vertexCount, 0, keyframeInterval, positionStep, 0);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    return file.good();
+}
+
+bool VertexCacheWriter::writeFrame(const glm::vec3* positions, const glm::vec3* normals) {
+    if (!isOpen()) return false;
+
+    bool keyframe = (frameOffsets.size() - 1) % keyframeInterval == 0;
+    unsigned char* out = buffer.data();
+
+    for (size_t i = 0; i < vertexCount; ++i) {
+        int32_t values[VertexCache::COMPONENTS];
+        values[0] = static_cast<int32_t>(std::lround(positions[i].x / positionStep));
+        values[1] = static_cast<int32_t>(std::lround(positions[i].y / positionStep));
+        values[2] = static_cast<int32_t>(std::lround(positions[i].z / positionStep));
+        VertexCache::encodeNormal(normals[i], values[3], values[4]);
+
+        int32_t* last = &previous[i * VertexCache::COMPONENTS];
+        for (int c = 0; c < VertexCache::COMPONENTS; ++c) {
+            out = VertexCache::writeVarint(keyframe ? values[c] : values[c] - last[c], out);
+            last[c] = values[c];
+        }
+    }
+
+    size_t frameSize = static_cast<size_t>(out - buffer.data());
+    file.write(reinterpret_cast<const char*>(buffer.data()), frameSize);
+    frameOffsets.push_back(frameOffsets.back() + frameSize);
+
+    return file.good();
+}
+
+bool VertexCacheWriter::close() {
+    if (!isOpen()) return false;
+
+    // Index goes after the frame data, 8-byte aligned
+    uint64_t indexOffset = (frameOffsets.back() + 7) & ~static_cast<uint64_t>(7);
+    static const char padding[8] = {};
+    file.write(padding, static_cast<std::streamsize>(indexOffset - frameOffsets.back()));
+    file.write(reinterpret_cast<const char*>(frameOffsets.data()), frameOffsets.size() * sizeof(uint64_t));
+
+    VertexCache::Header header;
+    VertexCache::fillHeader(header, vertexCount, static_cast<uint32_t>(frameOffsets.size() - 1),
+                            keyframeInterval, positionStep, indexOffset);
+    file.seekp(0);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    bool ok = file.good();
+    file.close();
+
+    previous.clear();
+    frameOffsets.clear();
+    buffer.clear();
+    return ok;
+}
+
+bool VertexCacheWriter::isOpen() const { return file.is_open(); }
+
+size_t VertexCacheWriter::getFrameCount() const {
+    return frameOffsets.empty() ? 0 : frameOffsets.size() - 1;
+}
+
+uint64_t VertexCacheWriter::getBytesWritten() const {
+    return frameOffsets.empty() ? 0 : frameOffsets.back();
+}
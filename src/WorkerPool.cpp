@@ -0,0 +1,147 @@
+#include "WorkerPool.h"
+
+#include <algorithm>
+
+// Set while this thread runs chunks of a loop, so a nested parallelFor()
+// runs inline instead of waiting on loopMutex held by the outer loop
+static thread_local bool insideLoop = false;
+
+WorkerPool& WorkerPool::getInstance() {
+    static WorkerPool instance;
+    return instance;
+}
+
+WorkerPool::WorkerPool()
+    : threadCount(std::max(1u, std::thread::hardware_concurrency())),
+      generation(0), stopping(false), activeWorkers(0),
+      loopFunction(nullptr), loopCount(0), loopChunkSize(1), loopChunkCount(0),
+      nextChunk(0), remainingChunks(0) {}
+
+WorkerPool::~WorkerPool() {
+    stopWorkers();
+}
+
+int WorkerPool::getThreadCount() const {
+    return threadCount;
+}
+
+void WorkerPool::setThreadCount(int count) {
+    std::lock_guard<std::mutex> loopLock(loopMutex);
+
+    count = std::max(1, count);
+    if (count == threadCount) return;
+
+    // Threads are started lazily by the next parallelFor()
+    stopWorkers();
+    threadCount = count;
+}
+
+void WorkerPool::parallelFor(size_t count, size_t chunkSize, const std::function<void(size_t, size_t)>& fn) {
+
+    if (count == 0) return;
+    chunkSize = std::max<size_t>(1, chunkSize);
+    size_t chunkCount = (count + chunkSize - 1) / chunkSize;
+
+    // Nothing to share, or called from a chunk of another loop: run on the calling thread
+    if (threadCount <= 1 || chunkCount == 1 || insideLoop) {
+        for (size_t begin = 0; begin < count; begin += chunkSize) {
+            fn(begin, std::min(count, begin + chunkSize));
+        }
+        return;
+    }
+
+    std::lock_guard<std::mutex> loopLock(loopMutex);
+
+    if (workers.empty()) startWorkers();
+
+    {
+        // A worker that woke late for the previous loop may still be leaving it
+        std::unique_lock<std::mutex> lock(mutex);
+        doneCondition.wait(lock, [this] { return activeWorkers == 0; });
+
+        loopFunction = &fn;
+        loopCount = count;
+        loopChunkSize = chunkSize;
+        loopChunkCount = chunkCount;
+        remainingChunks.store(chunkCount);
+        nextChunk.store(0);
+        ++generation;
+    }
+    wakeCondition.notify_all();
+
+    // The caller takes chunks too, then waits for the stragglers
+    runChunks();
+
+    std::unique_lock<std::mutex> lock(mutex);
+    doneCondition.wait(lock, [this] { return remainingChunks.load() == 0 && activeWorkers == 0; });
+    loopFunction = nullptr;
+}
+
+void WorkerPool::startWorkers() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = false;
+    }
+    for (int i = 1; i < threadCount; ++i) {
+        workers.emplace_back(&WorkerPool::workerLoop, this);
+    }
+}
+
+void WorkerPool::stopWorkers() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wakeCondition.notify_all();
+
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    workers.clear();
+}
+
+void WorkerPool::workerLoop() {
+    unsigned long seenGeneration;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        seenGeneration = generation;
+    }
+
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wakeCondition.wait(lock, [&] { return stopping || generation != seenGeneration; });
+            if (stopping) return;
+            seenGeneration = generation;
+            ++activeWorkers;
+        }
+
+        runChunks();
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            --activeWorkers;
+        }
+        doneCondition.notify_all();
+    }
+}
+
+void WorkerPool::runChunks() {
+    size_t chunk;
+    insideLoop = true;
+
+    while ((chunk = nextChunk.fetch_add(1)) < loopChunkCount) {
+        size_t begin = chunk * loopChunkSize;
+        size_t end = std::min(loopCount, begin + loopChunkSize);
+
+        (*loopFunction)(begin, end);
+
+        // Last chunk out wakes the thread waiting in parallelFor()
+        if (remainingChunks.fetch_sub(1) == 1) {
+            std::lock_guard<std::mutex> lock(mutex);
+            doneCondition.notify_all();
+        }
+    }
+
+    insideLoop = false;
+}
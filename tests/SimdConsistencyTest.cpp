@@ -0,0 +1,319 @@
+// The SIMD paths against scalar code, over random inputs whose sizes are
+// not a multiple of the vector width, so the tails run too. Paths the CPU
+// does not support are skipped.
+//
+//   make test
+
+#include "SkinningKernel.h"
+#include "SkinWeights.h"
+#include "DualQuaternion.h"
+#include "PoseBuffer.h"
+#include "JiggleBones.h"
+#include "SkeletalModel.h"
+#include "Joint.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+static int failures = 0;
+
+static void check(const std::string& name, float error, float tolerance) {
+    bool ok = error <= tolerance;
+    if (!ok) ++failures;
+    std::cout << name << ": max difference " << error << (ok ? "" : " FAILED") << std::endl;
+}
+
+static float maxDifference(const std::vector<glm::vec3>& a, const std::vector<glm::vec3>& b, size_t begin, size_t end) {
+    float error = 0.0f;
+    for (size_t i = begin; i < end; ++i) error = std::max(error, glm::length(a[i] - b[i]));
+    return error;
+}
+
+static glm::quat randomRotation(std::mt19937& random) {
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    return glm::normalize(glm::quat(unit(random), unit(random), unit(random), unit(random)));
+}
+
+// ImportCharacter's CPU_SCALAR loops over the CSR weights
+static void skinReference(const std::vector<glm::mat4>& palette, const std::vector<DualQuaternion>& dualPalette,
+                          const SkinWeights& weights, const std::vector<glm::vec3>& bindVertices,
+                          const std::vector<glm::vec3>& bindNormals, size_t begin, size_t end,
+                          std::vector<glm::vec3>& out, std::vector<glm::vec3>& outNormals,
+                          std::vector<glm::vec3>& dualOut, std::vector<glm::vec3>& dualOutNormals) {
+    const std::vector<unsigned int>& offsets = weights.getOffsets();
+    const std::vector<SkinWeights::Influence>& influences = weights.getInfluences();
+
+    for (size_t i = begin; i < end; ++i) {
+        glm::vec4 bindPos(bindVertices[i], 1.0f);
+        glm::vec4 bindNormal(bindNormals[i], 0.0f);
+        out[i] = outNormals[i] = glm::vec3(0.0f);
+
+        unsigned int heaviest = offsets[i];
+        for (unsigned int k = offsets[i]; k < offsets[i + 1]; ++k) {
+            const SkinWeights::Influence& influence = influences[k];
+            out[i] += influence.weight * glm::vec3(palette[influence.jointIndex] * bindPos);
+            outNormals[i] += influence.weight * glm::vec3(palette[influence.jointIndex] * bindNormal);
+            if (influence.weight > influences[heaviest].weight) heaviest = k;
+        }
+
+        const glm::quat& pivot = dualPalette[influences[heaviest].jointIndex].real;
+        DualQuaternion blend;
+        blend.real = glm::quat(0.0f, 0.0f, 0.0f, 0.0f);
+        for (unsigned int k = offsets[i]; k < offsets[i + 1]; ++k) {
+            const DualQuaternion& q = dualPalette[influences[k].jointIndex];
+            float weight = glm::dot(q.real, pivot) < 0.0f ? -influences[k].weight : influences[k].weight;
+            blend.real = blend.real + q.real * weight;
+            blend.dual = blend.dual + q.dual * weight;
+        }
+        blend.normalize();
+        dualOut[i] = blend.transformPoint(bindVertices[i]);
+        dualOutNormals[i] = blend.transformVector(bindNormals[i]);
+    }
+}
+
+// Every kernel path against the reference: vertices in model-sized
+// ranges, 1 to 6 influences each, and a range that starts and ends inside
+// a block
+static void testSkinning(std::mt19937& random) {
+    const size_t VERTEX_COUNT = 1003;
+    const size_t JOINT_COUNT = 40;
+    const size_t BEGIN = 13, END = 997;
+
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    std::uniform_int_distribution<int> influenceCount(1, 6);
+    std::uniform_int_distribution<int> joint(0, JOINT_COUNT - 1);
+
+    std::vector<glm::vec3> bindVertices(VERTEX_COUNT), bindNormals(VERTEX_COUNT);
+    std::vector<std::vector<float>> attachments(VERTEX_COUNT, std::vector<float>(JOINT_COUNT, 0.0f));
+    for (size_t v = 0; v < VERTEX_COUNT; ++v) {
+        bindVertices[v] = 2.0f * glm::vec3(unit(random), unit(random), unit(random));
+        bindNormals[v] = glm::normalize(glm::vec3(unit(random), unit(random), unit(random)) + glm::vec3(0.0f, 0.0f, 2.0f));
+
+        float sum = 0.0f;
+        for (int k = influenceCount(random); k > 0; --k) {
+            float weight = 0.05f + 0.5f * (unit(random) + 1.0f);
+            attachments[v][joint(random)] += weight;
+            sum += weight;
+        }
+        for (float& weight : attachments[v]) weight /= sum;
+    }
+
+    SkinWeights weights;
+    weights.setFromDense(attachments);
+    SkinningKernel kernel;
+    kernel.setup(bindVertices, bindNormals, weights);
+
+    const int SET_COUNT = SkinningKernel::AVX2 + 1;
+    float linearError[SET_COUNT] = {}, linearNormalError[SET_COUNT] = {};
+    float dualError[SET_COUNT] = {}, dualNormalError[SET_COUNT] = {};
+
+    for (int trial = 0; trial < 20; ++trial) {
+        std::vector<glm::mat4> palette(JOINT_COUNT);
+        std::vector<DualQuaternion> dualPalette(JOINT_COUNT);
+        for (size_t j = 0; j < JOINT_COUNT; ++j) {
+            glm::quat rotation = randomRotation(random);
+            glm::vec3 translation(unit(random), unit(random), unit(random));
+            palette[j] = glm::translate(glm::mat4(1.0f), translation) * glm::mat4_cast(rotation);
+            dualPalette[j] = DualQuaternion(rotation, translation);
+        }
+
+        std::vector<glm::vec3> expected(VERTEX_COUNT), expectedNormals(VERTEX_COUNT);
+        std::vector<glm::vec3> dualExpected(VERTEX_COUNT), dualExpectedNormals(VERTEX_COUNT);
+        skinReference(palette, dualPalette, weights, bindVertices, bindNormals, BEGIN, END,
+                      expected, expectedNormals, dualExpected, dualExpectedNormals);
+
+        for (int set = SkinningKernel::SCALAR; set < SET_COUNT; ++set) {
+            kernel.setInstructionSet(static_cast<SkinningKernel::InstructionSet>(set));
+            if (kernel.getInstructionSet() != set) continue;
+
+            std::vector<glm::vec3> out(VERTEX_COUNT), outNormals(VERTEX_COUNT);
+            kernel.skin(palette, BEGIN, END, out.data(), outNormals.data());
+            linearError[set] = std::max(linearError[set], maxDifference(out, expected, BEGIN, END));
+            linearNormalError[set] = std::max(linearNormalError[set], maxDifference(outNormals, expectedNormals, BEGIN, END));
+
+            kernel.skinDualQuaternion(dualPalette, BEGIN, END, out.data(), outNormals.data());
+            dualError[set] = std::max(dualError[set], maxDifference(out, dualExpected, BEGIN, END));
+            dualNormalError[set] = std::max(dualNormalError[set], maxDifference(outNormals, dualExpectedNormals, BEGIN, END));
+        }
+    }
+
+    for (int set = SkinningKernel::SCALAR; set < SET_COUNT; ++set) {
+        SkinningKernel::InstructionSet instructionSet = static_cast<SkinningKernel::InstructionSet>(set);
+        kernel.setInstructionSet(instructionSet);
+        if (kernel.getInstructionSet() != set) {
+            std::cout << "Skinning " << SkinningKernel::getInstructionSetName(instructionSet) << ": not supported, skipped" << std::endl;
+            continue;
+        }
+        std::string setName = SkinningKernel::getInstructionSetName(instructionSet);
+        check("Linear blend positions " + setName, linearError[set], SkinningKernel::SKINNING_TOLERANCE);
+        check("Linear blend normals " + setName, linearNormalError[set], SkinningKernel::SKINNING_TOLERANCE);
+        check("Dual quaternion positions " + setName, dualError[set], SkinningKernel::SKINNING_TOLERANCE);
+        check("Dual quaternion normals " + setName, dualNormalError[set], SkinningKernel::SKINNING_TOLERANCE);
+    }
+}
+
+static PoseBuffer randomPose(std::mt19937& random, size_t jointCount) {
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    PoseBuffer pose(jointCount);
+    for (size_t j = 0; j < jointCount; ++j) {
+        pose.setTranslation(j, glm::vec3(unit(random), unit(random), unit(random)));
+        pose.setRotation(j, randomRotation(random));
+        pose.setScale(j, glm::vec3(1.0f) + 0.5f * glm::vec3(unit(random), unit(random), unit(random)));
+    }
+    return pose;
+}
+
+static PoseBuffer jointPose(const PoseBuffer& pose, size_t joint) {
+    PoseBuffer single(1);
+    single.setTranslation(0, pose.getTranslation(joint));
+    single.setRotation(0, pose.getRotation(joint));
+    single.setScale(0, pose.getScale(joint));
+    return single;
+}
+
+static float poseDifference(const PoseBuffer& pose, size_t joint, const PoseBuffer& single) {
+    glm::quat a = pose.getRotation(joint), b = single.getRotation(0);
+    return std::max(std::max(glm::length(pose.getTranslation(joint) - single.getTranslation(0)),
+                             glm::length(pose.getScale(joint) - single.getScale(0))),
+                    glm::length(glm::vec4(a.x - b.x, a.y - b.y, a.z - b.z, a.w - b.w)));
+}
+
+// PoseBuffer picks SSE at compile time and runs the scalar loop for the
+// joints past the last group of 4, so a one-joint buffer is all scalar.
+// Blend a whole buffer and every joint on its own, and compare.
+static void testPoseBlending(std::mt19937& random) {
+    const size_t JOINT_COUNT = 103;
+    const float POSE_TOLERANCE = 1e-6f; // The same operations in the same order
+
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    float blendError = 0.0f, maskedBlendError = 0.0f, layerError = 0.0f, maskedLayerError = 0.0f;
+
+    for (int trial = 0; trial < 20; ++trial) {
+        PoseBuffer a = randomPose(random, JOINT_COUNT), b = randomPose(random, JOINT_COUNT);
+        PoseBuffer additive;
+        PoseBuffer::makeAdditive(b, a, additive);
+
+        std::vector<float> mask(JOINT_COUNT);
+        for (size_t j = 0; j < JOINT_COUNT; ++j) mask[j] = j % 5 == 0 ? static_cast<float>(j % 2) : unit(random);
+        float weight = unit(random);
+
+        PoseBuffer blended, maskedBlended, layered, maskedLayered;
+        PoseBuffer::blend(a, b, weight, blended);
+        PoseBuffer::maskedBlend(a, b, mask, weight, maskedBlended);
+        PoseBuffer::addLayer(a, additive, weight, nullptr, layered);
+        PoseBuffer::addLayer(a, additive, weight, &mask, maskedLayered);
+
+        for (size_t j = 0; j < JOINT_COUNT; ++j) {
+            PoseBuffer singleA = jointPose(a, j), singleB = jointPose(b, j), singleAdditive = jointPose(additive, j);
+            std::vector<float> singleMask(1, mask[j]);
+            PoseBuffer out;
+
+            PoseBuffer::blend(singleA, singleB, weight, out);
+            blendError = std::max(blendError, poseDifference(blended, j, out));
+            PoseBuffer::maskedBlend(singleA, singleB, singleMask, weight, out);
+            maskedBlendError = std::max(maskedBlendError, poseDifference(maskedBlended, j, out));
+            PoseBuffer::addLayer(singleA, singleAdditive, weight, nullptr, out);
+            layerError = std::max(layerError, poseDifference(layered, j, out));
+            PoseBuffer::addLayer(singleA, singleAdditive, weight, &singleMask, out);
+            maskedLayerError = std::max(maskedLayerError, poseDifference(maskedLayered, j, out));
+        }
+    }
+
+    check("PoseBuffer blend", blendError, POSE_TOLERANCE);
+    check("PoseBuffer maskedBlend", maskedBlendError, POSE_TOLERANCE);
+    check("PoseBuffer addLayer", layerError, POSE_TOLERANCE);
+    check("PoseBuffer addLayer with mask", maskedLayerError, POSE_TOLERANCE);
+}
+
+// Root with one two-bone arm per jiggle joint; the arm tips jiggle
+static void buildArms(SkeletalModel& model, size_t armCount) {
+    std::vector<Joint*> joints;
+    joints.push_back(new Joint);
+    for (size_t i = 0; i < armCount; ++i) {
+        float angle = 6.2831853f * i / armCount;
+        Joint* arm = new Joint;
+        Joint* tip = new Joint;
+        arm->setTransform(glm::translate(glm::mat4(1.0f), 0.3f * glm::vec3(std::cos(angle), 0.0f, std::sin(angle))));
+        tip->setTransform(glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.5f, 0.0f)));
+        arm->addChild(tip);
+        joints.front()->addChild(arm);
+        joints.push_back(arm);
+        joints.push_back(tip);
+    }
+    model.setRootJoint(joints.front());
+    model.setJoints(joints);
+    model.computeBindWorldToJointTransforms();
+    model.updateCurrentJointToWorldTransforms();
+}
+
+// JiggleBones pads its lanes to a multiple of 8 instead of running a
+// scalar tail. Step the same animation with every path on 11 particles
+// and compare where the tips end up.
+static void testJiggleBones() {
+    const size_t ARM_COUNT = 11;
+    const int FRAMES = 240;
+    const float JIGGLE_TOLERANCE = 1e-5f; // Model units, after FRAMES frames (AVX2 uses FMA)
+
+    const int SET_COUNT = SkinningKernel::AVX2 + 1;
+    SkeletalModel models[SET_COUNT];
+    JiggleBones jiggleBones[SET_COUNT];
+
+    for (int set = SkinningKernel::SCALAR; set < SET_COUNT; ++set) {
+        buildArms(models[set], ARM_COUNT);
+        for (size_t i = 0; i < ARM_COUNT; ++i) jiggleBones[set].addJoint(models[set], static_cast<int>(2 + 2 * i), 60.0f + 20.0f * i, 0.02f + 0.01f * i);
+        jiggleBones[set].setInstructionSet(static_cast<SkinningKernel::InstructionSet>(set));
+    }
+
+    float error[SET_COUNT] = {};
+    for (int frame = 0; frame < FRAMES; ++frame) {
+        float time = frame / 60.0f;
+
+        // Swing the root and the arms; the tips lag behind
+        for (int set = SkinningKernel::SCALAR; set < SET_COUNT; ++set) {
+            if (jiggleBones[set].getInstructionSet() != set) continue;
+
+            SkeletalModel& model = models[set];
+            model.setJointTranslation(0, glm::vec3(0.4f * std::sin(3.0f * time), 0.2f * std::sin(5.0f * time), 0.0f));
+            for (size_t i = 0; i < ARM_COUNT; ++i) {
+                model.setJointRotation(static_cast<int>(1 + 2 * i), glm::angleAxis(0.6f * std::sin(4.0f * time + i), glm::vec3(0.0f, 0.0f, 1.0f)));
+            }
+            jiggleBones[set].update(model, 1.0 / 60.0);
+        }
+
+        for (int set = SkinningKernel::SSE4; set < SET_COUNT; ++set) {
+            if (jiggleBones[set].getInstructionSet() != set) continue;
+            for (size_t i = 0; i < ARM_COUNT; ++i) {
+                int tip = static_cast<int>(2 + 2 * i);
+                glm::vec3 expected(models[SkinningKernel::SCALAR].getJointToWorldTransform(tip)[3]);
+                glm::vec3 actual(models[set].getJointToWorldTransform(tip)[3]);
+                error[set] = std::max(error[set], glm::length(actual - expected));
+            }
+        }
+    }
+
+    for (int set = SkinningKernel::SSE4; set < SET_COUNT; ++set) {
+        std::string setName = SkinningKernel::getInstructionSetName(static_cast<SkinningKernel::InstructionSet>(set));
+        if (jiggleBones[set].getInstructionSet() != set) {
+            std::cout << "JiggleBones " << setName << ": not supported, skipped" << std::endl;
+            continue;
+        }
+        check("JiggleBones " + setName, error[set], JIGGLE_TOLERANCE);
+    }
+}
+
+int main() {
+    std::mt19937 random(20240611);
+    testSkinning(random);
+    testPoseBlending(random);
+    testJiggleBones();
+
+    std::cout << failures << " failures" << std::endl;
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,88 @@
+// Back-to-back parallelFor() calls with alternating loop sizes. A worker
+// still leaving one loop must never run a chunk of the next: every element
+// is visited exactly once per loop, and no loop hangs. Then loops whose
+// chunks call parallelFor() again, which must run inline instead of deadlocking.
+//
+//   make test
+
+#include "WorkerPool.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+int main() {
+    const int LOOPS = 20000;
+    const int NESTED_LOOPS = 2000;
+    const size_t SIZES[] = { 3, 40, 1, 17, 200 }; // Chunks per loop, chunk size 1
+    const size_t OUTER = 8, INNER = 25;           // Nested loops: 8 chunks of 25 elements
+
+    WorkerPool pool;
+    pool.setThreadCount(4);
+
+    // A deadlocked loop never returns; fail instead of hanging
+    std::atomic<int> finishedLoops(0);
+    std::thread watchdog([&finishedLoops] {
+        int last = -1;
+        auto lastProgress = std::chrono::steady_clock::now();
+        while (finishedLoops.load() < LOOPS + NESTED_LOOPS) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            int now = finishedLoops.load();
+            if (now != last) {
+                last = now;
+                lastProgress = std::chrono::steady_clock::now();
+            } else if (std::chrono::steady_clock::now() - lastProgress > std::chrono::seconds(5)) {
+                std::cerr << "parallelFor stuck after " << now << " loops" << std::endl;
+                std::_Exit(1);
+            }
+        }
+    });
+
+    std::vector<std::atomic<int>> visits(200);
+    int failures = 0;
+
+    for (int loop = 0; loop < LOOPS; ++loop) {
+        size_t count = SIZES[loop % (sizeof(SIZES) / sizeof(SIZES[0]))];
+        for (size_t i = 0; i < count; ++i) visits[i].store(0);
+
+        pool.parallelFor(count, 1, [&visits](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) visits[i].fetch_add(1);
+            std::this_thread::yield(); // Widen the window between claiming and finishing
+        });
+
+        for (size_t i = 0; i < count; ++i) {
+            if (visits[i].load() != 1 && failures++ < 10) {
+                std::cerr << "Loop " << loop << ": element " << i << " of " << count
+                          << " ran " << visits[i].load() << " times" << std::endl;
+            }
+        }
+        finishedLoops.fetch_add(1);
+    }
+
+    for (int loop = 0; loop < NESTED_LOOPS; ++loop) {
+        for (size_t i = 0; i < OUTER * INNER; ++i) visits[i].store(0);
+
+        pool.parallelFor(OUTER, 1, [&](size_t begin, size_t end) {
+            for (size_t outer = begin; outer < end; ++outer) {
+                pool.parallelFor(INNER, 4, [&](size_t innerBegin, size_t innerEnd) {
+                    for (size_t i = innerBegin; i < innerEnd; ++i) visits[outer * INNER + i].fetch_add(1);
+                });
+            }
+        });
+
+        for (size_t i = 0; i < OUTER * INNER; ++i) {
+            if (visits[i].load() != 1 && failures++ < 10) {
+                std::cerr << "Nested loop " << loop << ": element " << i
+                          << " ran " << visits[i].load() << " times" << std::endl;
+            }
+        }
+        finishedLoops.fetch_add(1);
+    }
+
+    watchdog.join();
+    std::cout << LOOPS << " loops, " << NESTED_LOOPS << " nested loops, " << failures << " failures" << std::endl;
+    return failures == 0 ? 0 : 1;
+}